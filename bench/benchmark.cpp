@@ -0,0 +1,691 @@
+// Benchmarks the hot paths of the shadow caster and prints the results as JSON
+//
+// Usage: benchmark [--budget seconds] [--max-segments count]
+//
+// Every case is repeated until it has run for at least the budget (0.25s by default).
+// "operations" counts those passes and "ns_per_op" is the time of one pass, whatever a pass
+// does. How much a pass got through is in "rays_per_second" and "pixels_per_second".
+// Scenes are synthetic and seeded, so two runs on the same machine measure the same work.
+// Segment counts go up by ten times from 10 to --max-segments (1000000 by default). A case
+// that cannot be set up at some count prints a record with "skipped" and the reason
+// instead of its timings, so every count shows up in the output.
+//
+// Checks print a record with how many of their trials failed instead of timings, and make
+// the benchmark exit with 1 if any trial did.
+
+#define PGE_SHADOW_CASTING_NO_MAIN
+#include "../src/PGE_2d_shadow_casting.cpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The amount of work done by one call of a benchmarked function
+ */
+struct Work
+{
+  uint64_t rays;
+  uint64_t pixels;
+};
+
+/**
+ * @brief Has access to the internals of the application, so it can load scenes directly
+ */
+class Benchmark
+{
+public:
+  Benchmark(const double budget, const size_t maxSegments) : budget(budget), maxSegments(maxSegments)
+  {
+  }
+
+  int Run()
+  {
+    app.olc_ConfigureHeadless();
+    if (!app.Construct(1280, 820, 1, 1))
+    {
+      return 1;
+    }
+
+    app.olc_PrepareEngine();
+    app.OnUserCreate();
+
+    std::printf("[\n");
+
+    CalculateIntersection();
+
+    for (size_t segments = 10; segments <= maxSegments; segments *= 10)
+    {
+      const std::vector<Segment> walls = RandomWalls(segments);
+      Raycast(walls);
+      Visibility(walls);
+    }
+
+    for (size_t segments = 10; segments <= maxSegments; segments *= 10)
+    {
+      if (segments <= latticeLimit)
+      {
+        CastLight(segments);
+        CheckVisibilityPatch(segments);
+      }
+      else
+      {
+        for (const char* name : {"cast_light_sweep", "cast_light_rays", "cast_light_sweep_moving", "cast_light_rays_moving", "cast_light_soft", "visibility_patch_check"})
+        {
+          Skip(name, segments, "the grid of the application holds 53319 distinct lines");
+        }
+      }
+    }
+
+    for (size_t segments = 10; segments <= maxSegments; segments *= 10)
+    {
+      DrawLine(RandomWalls(segments));
+    }
+
+    FillTriangle();
+    LightMap();
+    FillRect();
+    Clear();
+
+    std::printf("\n]\n");
+    return failed ? 1 : 0;
+  }
+
+private:
+  // The 65x36 grid of the application holds 53319 distinct lines of the kind CastLight()
+  // places, the largest power of ten below that is the last count it can fill
+  static constexpr size_t latticeLimit = 10000;
+
+  PGE_2d_shadow_casting app;
+  double budget;
+  size_t maxSegments;
+  bool first = true;
+  bool failed = false;
+  std::mt19937 random{1234};
+
+  olc::vf2d boundsMin = {0.0f, 100.0f};
+  olc::vf2d boundsMax = {1280.0f, 820.0f};
+
+  float Uniform(const float from, const float to)
+  {
+    return std::uniform_real_distribution<float>(from, to)(random);
+  }
+
+  olc::vf2d RandomPoint()
+  {
+    return {Uniform(boundsMin.x + 1.0f, boundsMax.x - 1.0f), Uniform(boundsMin.y + 1.0f, boundsMax.y - 1.0f)};
+  }
+
+  /**
+   * @brief Scatters walls over the grid field, the more walls the shorter they get
+   */
+  std::vector<Segment> RandomWalls(const size_t count)
+  {
+    const float length = std::clamp(4000.0f / std::sqrt((float)count), 2.0f, 300.0f);
+
+    std::vector<Segment> walls;
+    walls.reserve(count);
+    for (size_t i = 0; i < count; i++)
+    {
+      const olc::vf2d start = RandomPoint();
+      const float angle = Uniform(0.0f, 2.0f * (float)M_PI);
+      olc::vf2d end = start + olc::vf2d(std::cos(angle), std::sin(angle)) * Uniform(0.5f, 1.0f) * length;
+      end = end.max(boundsMin).min(boundsMax);
+      walls.push_back({start, end});
+    }
+
+    return walls;
+  }
+
+  /**
+   * @brief Repeats an operation until the budget is used up and prints one JSON record
+   */
+  template <typename Operation>
+  void Measure(const std::string& name, const size_t segments, Operation&& operation)
+  {
+    using clock = std::chrono::steady_clock;
+
+    uint64_t operations = 0;
+    Work total = {0, 0};
+    const auto start = clock::now();
+    double elapsed = 0.0;
+    do
+    {
+      const Work work = operation();
+      operations++;
+      total.rays += work.rays;
+      total.pixels += work.pixels;
+      elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    } while (elapsed < budget);
+
+    std::printf("%s  {\"name\": \"%s\", \"segments\": %zu, \"operations\": %llu, \"ns_per_op\": %.2f", first ? "" : ",\n", name.c_str(), segments, (unsigned long long)operations, elapsed * 1e9 / (double)operations);
+    if (total.rays > 0)
+    {
+      std::printf(", \"rays_per_second\": %.0f", (double)total.rays / elapsed);
+    }
+    if (total.pixels > 0)
+    {
+      std::printf(", \"pixels_per_second\": %.0f", (double)total.pixels / elapsed);
+    }
+    std::printf("}");
+    std::fflush(stdout);
+    first = false;
+  }
+
+  /**
+   * @brief Prints the record of a case that could not run at this segment count
+   */
+  void Skip(const std::string& name, const size_t segments, const std::string& reason)
+  {
+    std::printf("%s  {\"name\": \"%s\", \"segments\": %zu, \"skipped\": \"%s\"}", first ? "" : ",\n", name.c_str(), segments, reason.c_str());
+    std::fflush(stdout);
+    first = false;
+  }
+
+  /**
+   * @brief Prints the record of a check, which fails if any of its trials did
+   */
+  void Report(const std::string& name, const size_t segments, const size_t trials, const size_t failures)
+  {
+    std::printf("%s  {\"name\": \"%s\", \"segments\": %zu, \"trials\": %zu, \"failures\": %zu}", first ? "" : ",\n", name.c_str(), segments, trials, failures);
+    std::fflush(stdout);
+    first = false;
+    failed = failed || failures > 0;
+  }
+
+  /**
+   * @brief The area covered by exactly one of two polygons, sampled at every pixel row of the bounds
+   */
+  double DifferingArea(const std::vector<olc::vf2d>& a, const std::vector<olc::vf2d>& b) const
+  {
+    // Crossings of both polygons with a row, tagged with the polygon they belong to
+    std::vector<std::pair<float, int>> crossings;
+    double area = 0.0;
+
+    for (float y = boundsMin.y + 0.5f; y < boundsMax.y; y += 1.0f)
+    {
+      crossings.clear();
+      for (int polygon = 0; polygon < 2; polygon++)
+      {
+        const std::vector<olc::vf2d>& vertices = polygon == 0 ? a : b;
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+          const olc::vf2d& start = vertices[i];
+          const olc::vf2d& end = vertices[(i + 1) % vertices.size()];
+          if ((start.y <= y) != (end.y <= y))
+          {
+            crossings.push_back({start.x + (y - start.y) / (end.y - start.y) * (end.x - start.x), polygon});
+          }
+        }
+      }
+      std::sort(crossings.begin(), crossings.end());
+
+      bool inside[2] = {false, false};
+      for (size_t i = 0; i < crossings.size(); i++)
+      {
+        inside[crossings[i].second] = !inside[crossings[i].second];
+        if (inside[0] != inside[1] && i + 1 < crossings.size())
+        {
+          area += crossings[i + 1].first - crossings[i].first;
+        }
+      }
+    }
+
+    return area;
+  }
+
+  /**
+   * @brief Patches polygons for random walls added to or removed from lattice scenes and
+   * compares them against polygons computed from scratch
+   *
+   * Half of the lights sit in the middle of a grid cell, where lattice points line up
+   * exactly on both sides of the light. Those also get a wall through the point opposite
+   * an end of the changed wall, which puts old vertices on the ray opposite the wedge.
+   */
+  void CheckVisibilityPatch(const size_t segments)
+  {
+    const size_t trials = std::max<size_t>(64, 100000 / segments);
+
+    std::uniform_int_distribution<int> x(0, 64);
+    std::uniform_int_distribution<int> y(6, 41);
+    std::uniform_int_distribution<int> offset(-3, 3);
+    std::uniform_int_distribution<int> column(0, 63);
+    std::uniform_int_distribution<int> row(5, 40);
+    auto RandomLatticeWall = [&]()
+    {
+      const olc::vf2d start = {20.0f * x(random), 20.0f * y(random)};
+      olc::vf2d end = start + olc::vf2d{20.0f * offset(random), 20.0f * offset(random)};
+      end = end.max(boundsMin).min(boundsMax);
+      return Segment{start, end};
+    };
+
+    std::vector<Segment> walls;
+    while (walls.size() < segments)
+    {
+      const Segment wall = RandomLatticeWall();
+      if (wall.start != wall.end)
+      {
+        walls.push_back(wall);
+      }
+    }
+
+    VisibilitySolver solver;
+    VisibilityPatcher patcher;
+    UniformGrid grid;
+    std::vector<olc::vf2d> patched;
+    std::vector<olc::vf2d> computed;
+    size_t failures = 0;
+
+    for (size_t trial = 0; trial < trials; trial++)
+    {
+      const olc::vf2d light = (trial % 2 == 0)
+        ? olc::vf2d{20.0f * column(random) + 10.0f, 20.0f * row(random) + 10.0f}
+        : olc::vf2d{std::round(Uniform(boundsMin.x + 1.0f, boundsMax.x - 1.0f)), std::round(Uniform(boundsMin.y + 1.0f, boundsMax.y - 1.0f))};
+
+      Segment wall = RandomLatticeWall();
+      while (wall.start == wall.end)
+      {
+        wall = RandomLatticeWall();
+      }
+
+      // Adding the wall goes from walls to walls + wall, removing it the other way round
+      const bool added = trial % 4 < 2;
+      std::vector<Segment> before = walls;
+      if (trial % 2 == 0)
+      {
+        const olc::vf2d mirrored = light * 2.0f - ((trial % 8 < 4) ? wall.start : wall.end);
+        const olc::vf2d end = (mirrored + olc::vf2d{20.0f * offset(random), 20.0f * offset(random)}).max(boundsMin).min(boundsMax);
+        if (mirrored.x > boundsMin.x && mirrored.x < boundsMax.x && mirrored.y > boundsMin.y && mirrored.y < boundsMax.y && end != mirrored)
+        {
+          before.push_back({mirrored, end});
+        }
+      }
+
+      std::vector<Segment> after = before;
+      (added ? after : before).push_back(wall);
+
+      grid.Resize((int)boundsMax.x, (int)boundsMax.y, 20);
+      for (const auto& remaining : after)
+      {
+        grid.Insert(remaining);
+      }
+      grid.Prepare();
+
+      solver.Compute(light, before, boundsMin, boundsMax, patched);
+      const bool patchedInPlace = added
+        ? patcher.InsertWall(solver, light, wall, boundsMin, boundsMax, patched)
+        : patcher.RemoveWall(solver, light, wall, grid, boundsMin, boundsMax, patched);
+
+      // Giving up is allowed, the application then recomputes the polygon
+      if (!patchedInPlace)
+      {
+        continue;
+      }
+
+      solver.Compute(light, after, boundsMin, boundsMax, computed);
+      if (DifferingArea(patched, computed) > 1.0)
+      {
+        failures++;
+      }
+    }
+
+    Report("visibility_patch_check", segments, trials, failures);
+  }
+
+  void CalculateIntersection()
+  {
+    const std::vector<Segment> a = RandomWalls(4096);
+    const std::vector<Segment> b = RandomWalls(4096);
+
+    float sink = 0.0f;
+    // A pair of lines rather than a scene, so like the drawing cases it reports no segments
+    Measure("calculate_intersection", 0, [&]()
+    {
+      for (size_t i = 0; i < a.size(); i++)
+      {
+        sink += app.CalculateIntersection(a[i].start, a[i].end, b[i].start, b[i].end).x;
+      }
+      return Work{a.size(), 0};
+    });
+
+    if (sink == 1.0f)
+    {
+      std::printf(" ");
+    }
+  }
+
+  /**
+   * @brief Random rays from random origins against every index
+   */
+  void Raycast(const std::vector<Segment>& walls)
+  {
+    BruteForceIndex list;
+    UniformGrid grid;
+    SegmentBVH tree;
+    grid.Resize((int)boundsMax.x, (int)boundsMax.y, 20);
+
+    for (const auto& wall : walls)
+    {
+      list.Insert(wall);
+      grid.Insert(wall);
+      tree.Insert(wall);
+    }
+    list.Prepare();
+    grid.Prepare();
+    tree.Prepare();
+
+    std::vector<std::pair<olc::vf2d, olc::vf2d>> rays(1024);
+    for (auto& ray : rays)
+    {
+      ray = {RandomPoint(), RandomPoint()};
+      ray.second -= ray.first;
+    }
+
+    const std::pair<const char*, const OccluderIndex*> indices[] = {{"raycast_brute_force", &list}, {"raycast_uniform_grid", &grid}, {"raycast_bvh", &tree}};
+    for (const auto& index : indices)
+    {
+      // Testing every wall gets slow quickly, fewer rays per round keep the rounds short
+      const size_t count = index.second == &list ? std::max<size_t>(1, std::min(rays.size(), 1000000 / walls.size())) : rays.size();
+
+      int sink = 0;
+      Measure(index.first, walls.size(), [&]()
+      {
+        for (size_t i = 0; i < count; i++)
+        {
+          sink += index.second->Raycast(rays[i].first, rays[i].second, 1.0f).segment;
+        }
+        return Work{count, 0};
+      });
+
+      if (sink == 1)
+      {
+        std::printf(" ");
+      }
+    }
+  }
+
+  /**
+   * @brief Visibility polygons for random light positions with both methods
+   */
+  void Visibility(const std::vector<Segment>& walls)
+  {
+    UniformGrid grid;
+    grid.Resize((int)boundsMax.x, (int)boundsMax.y, 20);
+    for (const auto& wall : walls)
+    {
+      grid.Insert(wall);
+    }
+    grid.Prepare();
+
+    std::vector<olc::vf2d> lights(16);
+    for (auto& light : lights)
+    {
+      light = RandomPoint();
+    }
+
+    VisibilitySolver sweep;
+    RayVisibility rays;
+    CrossingSplitter splitter;
+    std::vector<olc::vf2d> polygon;
+    size_t next = 0;
+
+    // Done once per change to the walls, the pieces are then shared by every light
+    Measure("split_crossings", walls.size(), [&]()
+    {
+      splitter.Split(walls, boundsMin, boundsMax);
+      return Work{0, 0};
+    });
+
+    Measure("visibility_sweep", walls.size(), [&]()
+    {
+      sweep.Compute(lights[next++ % lights.size()], splitter, boundsMin, boundsMax, polygon);
+      return Work{0, 0};
+    });
+
+    // Three rays are cast at every distinct endpoint, plus the four corners of the bounds
+    Measure("visibility_rays_uniform_grid", walls.size(), [&]()
+    {
+      rays.Compute(lights[next++ % lights.size()], walls, grid, boundsMin, boundsMax, polygon);
+      return Work{3 * (2 * walls.size() + 4), 0};
+    });
+  }
+
+  /**
+   * @brief The whole light pipeline of the application with four lights and nothing cached
+   */
+  void CastLight(const size_t segments)
+  {
+    app.lines.Clear();
+    app.wallOptimizer.Clear();
+    app.wallList.Clear();
+    app.wallGrid.Clear();
+    app.wallTree.Clear();
+
+    std::uniform_int_distribution<int> x(0, 64);
+    std::uniform_int_distribution<int> y(6, 41);
+    std::uniform_int_distribution<int> offset(-3, 3);
+
+    while (app.lines.size() < segments)
+    {
+      const int x1 = x(random);
+      const int y1 = y(random);
+      const line created = {x1, y1, std::clamp(x1 + offset(random), 0, 64), std::clamp(y1 + offset(random), 5, 41)};
+
+      if ((created.x1 != created.x2 || created.y1 != created.y2) && app.lines.Insert(created))
+      {
+        app.retiredWalls.clear();
+        app.newWalls.clear();
+        app.wallOptimizer.Insert(created, app.retiredWalls, app.newWalls);
+        app.UpdateOccluderIndices();
+      }
+    }
+
+    app.lights.clear();
+    for (int i = 0; i < 4; i++)
+    {
+      const olc::vf2d position = RandomPoint();
+      app.lights.push_back({{(int)position.x, (int)position.y}, olc::Pixel(200, 160, 120)});
+    }
+    app.mouse = {0, 0};
+
+    const std::pair<const char*, VISIBILITY> methods[] = {{"cast_light_sweep", ANGULAR_SWEEP}, {"cast_light_rays", RAY_CASTING}};
+    for (const auto& method : methods)
+    {
+      app.visibilityMethod = method.second;
+
+      Measure(method.first, segments, [&]()
+      {
+        // A new generation makes every cached polygon stale
+        app.sceneGeneration++;
+        app.CastLight();
+        return Work{0, 0};
+      });
+    }
+
+    // The usual frame, the lines stay put and only the lights move, so the sweep keeps its split walls
+    const std::pair<const char*, VISIBILITY> moving[] = {{"cast_light_sweep_moving", ANGULAR_SWEEP}, {"cast_light_rays_moving", RAY_CASTING}};
+    for (const auto& method : moving)
+    {
+      app.visibilityMethod = method.second;
+
+      Measure(method.first, segments, [&]()
+      {
+        for (auto& light : app.lights)
+        {
+          const olc::vf2d position = RandomPoint();
+          light.position = {(int)position.x, (int)position.y};
+        }
+        app.CastLight();
+        return Work{0, 0};
+      });
+    }
+
+    // Area lights cast one polygon per sample point
+    app.visibilityMethod = ANGULAR_SWEEP;
+    app.SetLightSamples(8);
+    Measure("cast_light_soft", segments, [&]()
+    {
+      app.sceneGeneration++;
+      app.CastLight();
+      return Work{0, 0};
+    });
+    app.SetLightSamples(1);
+  }
+
+  void DrawLine(const std::vector<Segment>& walls)
+  {
+    uint64_t pixels = 0;
+    for (const auto& wall : walls)
+    {
+      pixels += (uint64_t)std::max(std::abs((int)wall.end.x - (int)wall.start.x), std::abs((int)wall.end.y - (int)wall.start.y)) + 1;
+    }
+
+    Measure("draw_line", walls.size(), [&]()
+    {
+      for (const auto& wall : walls)
+      {
+        app.DrawLine(wall.start, wall.end, olc::MAGENTA);
+      }
+      return Work{0, pixels};
+    });
+  }
+
+  /**
+   * @brief Triangles the size of the fans the original light polygon was drawn with
+   */
+  void FillTriangle()
+  {
+    std::vector<olc::vf2d> corners(3 * 256);
+    uint64_t pixels = 0;
+    for (size_t i = 0; i < corners.size(); i += 3)
+    {
+      corners[i] = RandomPoint();
+      corners[i + 1] = RandomPoint();
+      corners[i + 2] = RandomPoint();
+      pixels += (uint64_t)(std::abs((corners[i + 1] - corners[i]).cross(corners[i + 2] - corners[i])) / 2.0f);
+    }
+
+    Measure("fill_triangle", 0, [&]()
+    {
+      for (size_t i = 0; i < corners.size(); i += 3)
+      {
+        app.FillTriangle(corners[i], corners[i + 1], corners[i + 2], olc::DARK_YELLOW);
+      }
+      return Work{0, pixels};
+    });
+  }
+
+  /**
+   * @brief Large lit areas the size of what a light in an open room covers, with and without falloff
+   */
+  void LightMap()
+  {
+    std::vector<std::vector<olc::vf2d>> polygons(8);
+    std::vector<olc::vf2d> origins;
+    for (auto& polygon : polygons)
+    {
+      const olc::vf2d origin = RandomPoint();
+      origins.push_back(origin);
+      for (int i = 0; i < 32; i++)
+      {
+        const float angle = 2.0f * (float)M_PI * (float)i / 32.0f;
+        polygon.push_back((origin + olc::vf2d(std::cos(angle), std::sin(angle)) * Uniform(200.0f, 600.0f)).max(boundsMin).min(boundsMax));
+      }
+    }
+
+    const uint64_t pixels = (uint64_t)(boundsMax.x - boundsMin.x) * (uint64_t)(boundsMax.y - boundsMin.y);
+    const LightValue light = LightValue::FromPixel(olc::Pixel(66, 53, 40));
+
+    for (const bool falloff : {false, true})
+    {
+      Measure(falloff ? "light_map_falloff" : "light_map_flat", 0, [&]()
+      {
+        app.lightMap.Begin(boundsMin, boundsMax);
+        for (size_t i = 0; i < polygons.size(); i++)
+        {
+          if (falloff)
+          {
+            app.lightMap.Bin(polygons[i], light, origins[i]);
+          }
+          else
+          {
+            app.lightMap.Bin(polygons[i], light);
+          }
+        }
+        app.lightMap.Render(app.workers, app.GetDrawTarget(), olc::BLACK);
+        return Work{0, pixels};
+      });
+    }
+  }
+
+  void FillRect()
+  {
+    std::vector<std::pair<olc::vi2d, olc::vi2d>> rects(256);
+    uint64_t pixels = 0;
+    for (auto& rect : rects)
+    {
+      const olc::vf2d a = RandomPoint();
+      const olc::vf2d b = RandomPoint();
+      rect = {a.min(b), (a.max(b) - a.min(b)) + olc::vf2d(1.0f, 1.0f)};
+      pixels += (uint64_t)rect.second.x * (uint64_t)rect.second.y;
+    }
+
+    Measure("fill_rect", 0, [&]()
+    {
+      for (const auto& rect : rects)
+      {
+        app.FillRect(rect.first, rect.second, olc::DARK_BLUE);
+      }
+      return Work{0, pixels};
+    });
+
+    // Translucent overlays read every pixel back and blend it
+    app.SetPixelMode(olc::Pixel::ALPHA);
+    Measure("fill_rect_alpha", 0, [&]()
+    {
+      for (const auto& rect : rects)
+      {
+        app.FillRect(rect.first, rect.second, olc::Pixel(40, 80, 160, 100));
+      }
+      return Work{0, pixels};
+    });
+    app.SetPixelMode(olc::Pixel::NORMAL);
+  }
+
+  void Clear()
+  {
+    const uint64_t pixels = (uint64_t)app.ScreenWidth() * (uint64_t)app.ScreenHeight();
+
+    Measure("clear", 0, [&]()
+    {
+      app.Clear(olc::BLACK);
+      return Work{0, pixels};
+    });
+  }
+};
+
+int main(int argc, char* argv[])
+{
+  double budget = 0.25;
+  size_t maxSegments = 1000000;
+
+  for (int i = 1; i + 1 < argc; i += 2)
+  {
+    const std::string argument = argv[i];
+
+    if (argument == "--budget")
+    {
+      budget = std::strtod(argv[i + 1], nullptr);
+    }
+    else if (argument == "--max-segments")
+    {
+      maxSegments = (size_t)std::strtoull(argv[i + 1], nullptr, 10);
+    }
+  }
+
+  Benchmark benchmark(budget, maxSegments);
+  return benchmark.Run();
+}
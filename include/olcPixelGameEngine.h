@@ -370,12 +370,24 @@ int main()
 #include <list>
 #include <thread>
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
 #include <fstream>
 #include <map>
 #include <functional>
 #include <algorithm>
 #include <array>
+#include <cstdio>
 #include <cstring>
+#if !defined(OLC_BLEND_SCALAR)
+	#if defined(__AVX2__)
+		#define OLC_BLEND_AVX2
+		#include <immintrin.h>
+	#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		#define OLC_BLEND_SSE2
+		#include <emmintrin.h>
+	#endif
+#endif
 #pragma endregion
 
 #define PGE_VER 219
@@ -420,6 +432,11 @@ int main()
 
 #define UNUSED(x) (void)(x)
 
+// Scoped timers around engine internals, define before including to profile them
+#if !defined(OLC_PROFILE_ZONE)
+	#define OLC_PROFILE_ZONE(name)
+#endif
+
 // O------------------------------------------------------------------------------O
 // | PLATFORM SELECTION CODE, Thanks slavka!                                      |
 // O------------------------------------------------------------------------------O
@@ -449,7 +466,7 @@ int main()
 #endif
 
 // Renderer
-#if !defined(OLC_GFX_OPENGL10) && !defined(OLC_GFX_OPENGL33) && !defined(OLC_GFX_DIRECTX10)
+#if !defined(OLC_GFX_OPENGL10) && !defined(OLC_GFX_OPENGL33) && !defined(OLC_GFX_DIRECTX10) && !defined(OLC_GFX_SOFTWARE)
 	#if !defined(OLC_GFX_CUSTOM_EX)
 		#if defined(OLC_PLATFORM_EMSCRIPTEN)
 			#define OLC_GFX_OPENGL33
@@ -503,7 +520,15 @@ int main()
 	{
 		#include <X11/X.h>
 		#include <X11/Xlib.h>
+	#if defined(OLC_GFX_SOFTWARE)
+		#include <X11/Xutil.h>
+		#include <X11/extensions/XShm.h>
+	#endif
 	}
+	#if defined(OLC_GFX_SOFTWARE)
+		#include <sys/ipc.h>
+		#include <sys/shm.h>
+	#endif
 #endif
 
 #if defined(OLC_PLATFORM_GLUT)
@@ -768,12 +793,24 @@ namespace olc
 		bool  SetPixel(const olc::vi2d& a, Pixel p);
 		Pixel Sample(float x, float y) const;
 		Pixel SampleBL(float u, float v) const;
+		// Writes through the returned pointer are not tracked, so it marks the whole sprite dirty
 		Pixel* GetData();
 		olc::Sprite* Duplicate();
 		olc::Sprite* Duplicate(const olc::vi2d& vPos, const olc::vi2d& vSize);
 		std::vector<olc::Pixel> pColData;
 		Mode modeSample = Mode::NORMAL;
 
+	public:
+		// The area written since the sprite was last uploaded to its decal, so that
+		// only that part has to be sent to the GPU again
+		void MarkDirty();
+		void MarkDirty(int32_t x, int32_t y, int32_t w = 1, int32_t h = 1);
+		void ClearDirty();
+		bool IsDirty() const;
+		bool IsFullyDirty() const;
+		olc::vi2d vDirtyMin = { 0, 0 };
+		olc::vi2d vDirtyMax = { 0, 0 };
+
 		static std::unique_ptr<olc::ImageLoader> loader;
 	};
 
@@ -858,7 +895,10 @@ namespace olc
 		bool bUpdate = false;
 		olc::Renderable pDrawTarget;
 		uint32_t nResID = 0;
+		// Instances are reused from frame to frame so their vectors keep their capacity,
+		// only the first nDecalInstances of them belong to the current frame
 		std::vector<DecalInstance> vecDecalInstance;
+		size_t nDecalInstances = 0;
 		olc::Pixel tint = olc::WHITE;
 		std::function<void()> funcHook = nullptr;
 	};
@@ -875,6 +915,8 @@ namespace olc
 		virtual void	   SetDecalMode(const olc::DecalMode& mode) = 0;
 		virtual void       DrawLayerQuad(const olc::vf2d& offset, const olc::vf2d& scale, const olc::Pixel tint) = 0;
 		virtual void       DrawDecal(const olc::DecalInstance& decal) = 0;
+		// Draws the decals of a layer in order, renderers that can batch them override this
+		virtual void       DrawDecals(const olc::DecalInstance* decals, size_t count) { for (size_t i = 0; i < count; i++) DrawDecal(decals[i]); }
 		virtual uint32_t   CreateTexture(const uint32_t width, const uint32_t height, const bool filtered = false, const bool clamp = true) = 0;
 		virtual void       UpdateTexture(uint32_t id, olc::Sprite* spr) = 0;
 		virtual void       ReadTexture(uint32_t id, olc::Sprite* spr) = 0;
@@ -1012,6 +1054,9 @@ namespace olc
 		// Draws a single Pixel
 		virtual bool Draw(int32_t x, int32_t y, Pixel p = olc::WHITE);
 		bool Draw(const olc::vi2d& pos, Pixel p = olc::WHITE);
+		// Draws a horizontal run of pixels from (x1,y) to (x2,y) inclusive, nothing if x2 < x1.
+		// It is clipped once and written as a whole, only Pixel::CUSTOM goes through Draw()
+		void DrawSpan(int32_t x1, int32_t x2, int32_t y, Pixel p = olc::WHITE);
 		// Draws a line from (x1,y1) to (x2,y2)
 		void DrawLine(int32_t x1, int32_t y1, int32_t x2, int32_t y2, Pixel p = olc::WHITE, uint32_t pattern = 0xFFFFFFFF);
 		void DrawLine(const olc::vi2d& pos1, const olc::vi2d& pos2, Pixel p = olc::WHITE, uint32_t pattern = 0xFFFFFFFF);
@@ -1153,6 +1198,16 @@ namespace olc
 		olc::Sprite*     pDrawTarget = nullptr;
 		Pixel::Mode	nPixelMode = Pixel::NORMAL;
 		float		fBlendFactor = 1.0f;
+		uint32_t	nBlendFactor = 255;
+
+		// Writes nCount pixels from pDst on, nStride apart, specialised per pixel mode.
+		// The untemplated one dispatches on nPixelMode and returns false for CUSTOM
+		template<Pixel::Mode mode> void olc_WriteSpan(Pixel* pDst, int32_t nCount, int32_t nStride, Pixel p) const;
+		bool olc_WriteSpan(Pixel* pDst, int32_t nCount, int32_t nStride, Pixel p) const;
+		// Row by row copy of a sprite region at scale 1, false if it has to be drawn per pixel
+		bool olc_DrawSpriteRows(int32_t x, int32_t y, Sprite* sprite, int32_t ox, int32_t oy, int32_t w, int32_t h, uint8_t flip);
+		// The next unused decal instance of the target layer, emptied but with its capacity kept
+		DecalInstance& olc_NewDecalInstance();
 		olc::vi2d	vScreenSize = { 256, 240 };
 		olc::vf2d	vInvScreenSize = { 1.0f / 256.0f, 1.0f / 240.0f };
 		olc::vi2d	vPixelSize = { 4, 4 };
@@ -1172,6 +1227,7 @@ namespace olc
 		bool		bEnableVSYNC = false;
 		float		fFrameTimer = 1.0f;
 		float		fLastElapsed = 0.0f;
+		float		fFixedElapsedTime = 0.0f;
 		int			nFrameCount = 0;		
 		bool bSuspendTextureTransfer = false;
 		Renderable  fontRenderable;
@@ -1240,10 +1296,16 @@ namespace olc
 		void olc_Terminate();
 		void olc_Reanimate();
 		bool olc_IsRunning();
+		// Replaces the clock with a constant time per frame, 0 restores the clock
+		void olc_SetFixedElapsedTime(float fElapsedTime);
 
 		// At the very end of this file, chooses which
 		// components to compile
 		virtual void olc_ConfigureSystem();
+		// Swaps in a platform and renderer that need no window or GPU, frames
+		// are only drawn into sprite memory. Call before Construct(). With pFrame,
+		// the layers are also composited into it by the software renderer
+		void olc_ConfigureHeadless(olc::Sprite* pFrame = nullptr);
 
 		// NOTE: Items Here are to be deprecated, I have left them in for now
 		// in case you are using them, but they will be removed.
@@ -1407,6 +1469,7 @@ namespace olc
 		width = w;		height = h;
 		pColData.resize(width * height);
 		pColData.resize(width * height, nDefaultPixel);
+		MarkDirty();
 	}
 
 	Sprite::~Sprite()
@@ -1444,6 +1507,7 @@ namespace olc
 		if (x >= 0 && x < width && y >= 0 && y < height)
 		{
 			pColData[y * width + x] = p;
+			MarkDirty(x, y);
 			return true;
 		}
 		else
@@ -1480,19 +1544,47 @@ namespace olc
 	}
 
 	Pixel* Sprite::GetData()
-	{ return pColData.data(); }
+	{ MarkDirty(); return pColData.data(); }
+
+	void Sprite::MarkDirty()
+	{ vDirtyMin = { 0, 0 }; vDirtyMax = { width, height }; }
+
+	void Sprite::MarkDirty(int32_t x, int32_t y, int32_t w, int32_t h)
+	{
+		// Callers pass areas already clipped to the sprite
+		if (vDirtyMin.x >= vDirtyMax.x || vDirtyMin.y >= vDirtyMax.y)
+		{
+			vDirtyMin = { x, y }; vDirtyMax = { x + w, y + h };
+			return;
+		}
+
+		vDirtyMin = { std::min(vDirtyMin.x, x), std::min(vDirtyMin.y, y) };
+		vDirtyMax = { std::max(vDirtyMax.x, x + w), std::max(vDirtyMax.y, y + h) };
+	}
+
+	void Sprite::ClearDirty()
+	{ vDirtyMin = { 0, 0 }; vDirtyMax = { 0, 0 }; }
+
+	bool Sprite::IsDirty() const
+	{ return vDirtyMin.x < vDirtyMax.x && vDirtyMin.y < vDirtyMax.y; }
+
+	bool Sprite::IsFullyDirty() const
+	{ return vDirtyMin.x == 0 && vDirtyMin.y == 0 && vDirtyMax.x >= width && vDirtyMax.y >= height; }
 
 
 	olc::rcode Sprite::LoadFromFile(const std::string& sImageFile, olc::ResourcePack* pack)
 	{
 		UNUSED(pack);
-		return loader->LoadImageResource(this, sImageFile, pack);
+		olc::rcode result = loader->LoadImageResource(this, sImageFile, pack);
+		MarkDirty();
+		return result;
 	}
 
 	olc::Sprite* Sprite::Duplicate()
 	{
 		olc::Sprite* spr = new olc::Sprite(width, height);
-		std::memcpy(spr->GetData(), GetData(), width * height * sizeof(olc::Pixel));
+		// Only the copy is written, reading through GetData() would dirty the source as well
+		std::memcpy(spr->GetData(), pColData.data(), width * height * sizeof(olc::Pixel));
 		spr->modeSample = modeSample;
 		return spr;
 	}
@@ -1515,6 +1607,8 @@ namespace olc
 		if (spr == nullptr) return;
 		sprite = spr;
 		id = renderer->CreateTexture(sprite->width, sprite->height, filter, clamp);
+		// A new texture has no storage yet, the whole sprite must go up at least once
+		sprite->MarkDirty();
 		Update();
 	}
 
@@ -1530,6 +1624,7 @@ namespace olc
 		vUVScale = { 1.0f / float(sprite->width), 1.0f / float(sprite->height) };
 		renderer->ApplyTexture(id);
 		renderer->UpdateTexture(id, sprite);
+		sprite->ClearDirty();
 	}
 
 	void Decal::UpdateSprite()
@@ -1537,6 +1632,7 @@ namespace olc
 		if (sprite == nullptr) return;
 		renderer->ApplyTexture(id);
 		renderer->ReadTexture(id, sprite);
+		sprite->ClearDirty();
 	}
 
 	Decal::~Decal()
@@ -1751,6 +1847,183 @@ namespace olc
 		return o;
 	};
 
+	// O------------------------------------------------------------------------------O
+	// | olc::span - Filling runs of memory with one opaque colour                    |
+	// O------------------------------------------------------------------------------O
+	namespace span
+	{
+		// Fills this large (in pixels) bypass the cache, they would only evict everything else.
+		// In practice that is a full-screen Clear() or a FillRect covering most of the screen
+		constexpr size_t nStreamThreshold = 256 * 1024;
+
+		// Streaming stores are weakly ordered, call Fence() once after the last Fill() that streamed
+		inline void Fence()
+		{
+#if defined(OLC_BLEND_SSE2) || defined(OLC_BLEND_AVX2)
+			_mm_sfence();
+#endif
+		}
+
+		inline void Fill(Pixel* pDst, size_t nCount, const Pixel p, bool bStream)
+		{
+#if defined(OLC_BLEND_SSE2) || defined(OLC_BLEND_AVX2)
+			if (bStream)
+			{
+				// Only whole cache lines are streamed, partly written lines would be flushed
+				// to memory one piece at a time. The odd pixels at either end are written normally
+				size_t nHead = std::min(nCount, (size_t)((64 - ((uintptr_t)pDst & 63)) & 63) / sizeof(Pixel));
+				std::fill_n(pDst, nHead, p);
+				pDst += nHead; nCount -= nHead;
+
+				const __m128i v = _mm_set1_epi32((int)p.n);
+				size_t i = 0;
+				for (; i + 16 <= nCount; i += 16)
+				{
+					_mm_stream_si128((__m128i*)(pDst + i), v);
+					_mm_stream_si128((__m128i*)(pDst + i + 4), v);
+					_mm_stream_si128((__m128i*)(pDst + i + 8), v);
+					_mm_stream_si128((__m128i*)(pDst + i + 12), v);
+				}
+
+				std::fill_n(pDst + i, nCount - i, p);
+				return;
+			}
+#endif
+			std::fill_n(pDst, nCount, p);
+		}
+	}
+
+	// O------------------------------------------------------------------------------O
+	// | olc::blend - Integer alpha blending, 8 or 4 pixels at a time where possible  |
+	// O------------------------------------------------------------------------------O
+	// All kernels compute (s * a + d * (255 - a)) / 255 per channel, rounded to nearest,
+	// and write an opaque result, so SIMD and scalar paths agree to the bit.
+	namespace blend
+	{
+		inline uint32_t Div255(uint32_t x)
+		{ x += 128; return (x + (x >> 8)) >> 8; }
+
+		// Source alpha scaled by the engine blend factor (0 - 255)
+		inline uint32_t Alpha(uint32_t a, uint32_t nBlend)
+		{ return nBlend == 255 ? a : Div255(a * nBlend); }
+
+		inline Pixel Mix(const Pixel s, const Pixel d, uint32_t a)
+		{
+			uint32_t c = 255 - a;
+			return Pixel((uint8_t)Div255(s.r * a + d.r * c), (uint8_t)Div255(s.g * a + d.g * c), (uint8_t)Div255(s.b * a + d.b * c));
+		}
+
+#if defined(OLC_BLEND_SSE2) || defined(OLC_BLEND_AVX2)
+		// Rounded division by 255 of eight 16 bit lanes that already hold +128
+		inline __m128i Div255(__m128i x)
+		{ return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8); }
+#endif
+#if defined(OLC_BLEND_AVX2)
+		inline __m256i Div255(__m256i x)
+		{ return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8); }
+#endif
+
+		// Blends one colour with alpha a (0 - 255) over nCount contiguous pixels
+		inline void ConstantSpan(Pixel* pDst, int32_t nCount, const Pixel p, uint32_t a)
+		{
+			if (a == 0) return;
+			if (a == 255) { std::fill_n(pDst, nCount, Pixel(p.r, p.g, p.b)); return; }
+
+			int32_t i = 0;
+#if defined(OLC_BLEND_AVX2)
+			{
+				const __m256i zero = _mm256_setzero_si256();
+				const __m256i opaque = _mm256_set1_epi32((int)0xFF000000);
+				const __m256i inv = _mm256_set1_epi16((short)(255 - a));
+				const __m256i src = _mm256_unpacklo_epi8(_mm256_set1_epi32((int)p.n), zero);
+				const __m256i sa = _mm256_add_epi16(_mm256_mullo_epi16(src, _mm256_set1_epi16((short)a)), _mm256_set1_epi16(128));
+				for (; i + 8 <= nCount; i += 8)
+				{
+					__m256i d = _mm256_loadu_si256((const __m256i*)(pDst + i));
+					__m256i lo = Div255(_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), inv), sa));
+					__m256i hi = Div255(_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), inv), sa));
+					_mm256_storeu_si256((__m256i*)(pDst + i), _mm256_or_si256(_mm256_packus_epi16(lo, hi), opaque));
+				}
+			}
+#endif
+#if defined(OLC_BLEND_SSE2) || defined(OLC_BLEND_AVX2)
+			{
+				const __m128i zero = _mm_setzero_si128();
+				const __m128i opaque = _mm_set1_epi32((int)0xFF000000);
+				const __m128i inv = _mm_set1_epi16((short)(255 - a));
+				const __m128i src = _mm_unpacklo_epi8(_mm_set1_epi32((int)p.n), zero);
+				const __m128i sa = _mm_add_epi16(_mm_mullo_epi16(src, _mm_set1_epi16((short)a)), _mm_set1_epi16(128));
+				for (; i + 4 <= nCount; i += 4)
+				{
+					__m128i d = _mm_loadu_si128((const __m128i*)(pDst + i));
+					__m128i lo = Div255(_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), inv), sa));
+					__m128i hi = Div255(_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), inv), sa));
+					_mm_storeu_si128((__m128i*)(pDst + i), _mm_or_si128(_mm_packus_epi16(lo, hi), opaque));
+				}
+			}
+#endif
+			for (; i < nCount; i++)
+				pDst[i] = Mix(p, pDst[i], a);
+		}
+
+		// Blends nCount source pixels, each with its own alpha scaled by nBlend (0 - 255)
+		inline void SourceSpan(Pixel* pDst, const Pixel* pSrc, int32_t nCount, uint32_t nBlend)
+		{
+			int32_t i = 0;
+#if defined(OLC_BLEND_AVX2)
+			{
+				const __m256i zero = _mm256_setzero_si256();
+				const __m256i opaque = _mm256_set1_epi32((int)0xFF000000);
+				const __m256i full = _mm256_set1_epi16(255);
+				const __m256i half = _mm256_set1_epi16(128);
+				const __m256i blend = _mm256_set1_epi16((short)nBlend);
+				auto Lanes = [&](__m256i s, __m256i d)
+				{
+					__m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, 0xFF), 0xFF);
+					if (nBlend != 255) a = Div255(_mm256_add_epi16(_mm256_mullo_epi16(a, blend), half));
+					__m256i x = _mm256_add_epi16(_mm256_mullo_epi16(s, a), _mm256_mullo_epi16(d, _mm256_sub_epi16(full, a)));
+					return Div255(_mm256_add_epi16(x, half));
+				};
+				for (; i + 8 <= nCount; i += 8)
+				{
+					__m256i s = _mm256_loadu_si256((const __m256i*)(pSrc + i));
+					__m256i d = _mm256_loadu_si256((const __m256i*)(pDst + i));
+					__m256i lo = Lanes(_mm256_unpacklo_epi8(s, zero), _mm256_unpacklo_epi8(d, zero));
+					__m256i hi = Lanes(_mm256_unpackhi_epi8(s, zero), _mm256_unpackhi_epi8(d, zero));
+					_mm256_storeu_si256((__m256i*)(pDst + i), _mm256_or_si256(_mm256_packus_epi16(lo, hi), opaque));
+				}
+			}
+#endif
+#if defined(OLC_BLEND_SSE2) || defined(OLC_BLEND_AVX2)
+			{
+				const __m128i zero = _mm_setzero_si128();
+				const __m128i opaque = _mm_set1_epi32((int)0xFF000000);
+				const __m128i full = _mm_set1_epi16(255);
+				const __m128i half = _mm_set1_epi16(128);
+				const __m128i blend = _mm_set1_epi16((short)nBlend);
+				auto Lanes = [&](__m128i s, __m128i d)
+				{
+					// Every pixel's alpha is spread over its four channels
+					__m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xFF), 0xFF);
+					if (nBlend != 255) a = Div255(_mm_add_epi16(_mm_mullo_epi16(a, blend), half));
+					__m128i x = _mm_add_epi16(_mm_mullo_epi16(s, a), _mm_mullo_epi16(d, _mm_sub_epi16(full, a)));
+					return Div255(_mm_add_epi16(x, half));
+				};
+				for (; i + 4 <= nCount; i += 4)
+				{
+					__m128i s = _mm_loadu_si128((const __m128i*)(pSrc + i));
+					__m128i d = _mm_loadu_si128((const __m128i*)(pDst + i));
+					__m128i lo = Lanes(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero));
+					__m128i hi = Lanes(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero));
+					_mm_storeu_si128((__m128i*)(pDst + i), _mm_or_si128(_mm_packus_epi16(lo, hi), opaque));
+				}
+			}
+#endif
+			for (; i < nCount; i++)
+				pDst[i] = Mix(pSrc[i], pDst[i], Alpha(pSrc[i].a, nBlend));
+		}
+	}
+
 	// O------------------------------------------------------------------------------O
 	// | olc::PixelGameEngine IMPLEMENTATION                                          |
 	// O------------------------------------------------------------------------------O
@@ -1967,12 +2240,7 @@ namespace olc
 		if (nPixelMode == Pixel::ALPHA)
 		{
 			Pixel d = pDrawTarget->GetPixel(x, y);
-			float a = (float)(p.a / 255.0f) * fBlendFactor;
-			float c = 1.0f - a;
-			float r = a * (float)p.r + c * (float)d.r;
-			float g = a * (float)p.g + c * (float)d.g;
-			float b = a * (float)p.b + c * (float)d.b;
-			return pDrawTarget->SetPixel(x, y, Pixel((uint8_t)r, (uint8_t)g, (uint8_t)b/*, (uint8_t)(p.a * fBlendFactor)*/));
+			return pDrawTarget->SetPixel(x, y, blend::Mix(p, d, blend::Alpha(p.a, nBlendFactor)));
 		}
 
 		if (nPixelMode == Pixel::CUSTOM)
@@ -1983,6 +2251,65 @@ namespace olc
 		return false;
 	}
 
+	template<Pixel::Mode mode>
+	void PixelGameEngine::olc_WriteSpan(Pixel* pDst, int32_t nCount, int32_t nStride, Pixel p) const
+	{
+		if constexpr (mode == Pixel::NORMAL)
+		{
+			// Compilers turn a contiguous fill into wide stores
+			if (nStride == 1)
+				std::fill_n(pDst, nCount, p);
+			else
+				for (int32_t i = 0; i < nCount; i++, pDst += nStride) *pDst = p;
+		}
+
+		if constexpr (mode == Pixel::MASK)
+		{
+			// One colour for the whole span, so it is either fully drawn or skipped
+			if (p.a == 255)
+				olc_WriteSpan<Pixel::NORMAL>(pDst, nCount, nStride, p);
+		}
+
+		if constexpr (mode == Pixel::ALPHA)
+		{
+			uint32_t a = blend::Alpha(p.a, nBlendFactor);
+			if (nStride == 1)
+				blend::ConstantSpan(pDst, nCount, p, a);
+			else
+				for (int32_t i = 0; i < nCount; i++, pDst += nStride) *pDst = blend::Mix(p, *pDst, a);
+		}
+	}
+
+	bool PixelGameEngine::olc_WriteSpan(Pixel* pDst, int32_t nCount, int32_t nStride, Pixel p) const
+	{
+		switch (nPixelMode)
+		{
+		case Pixel::NORMAL: olc_WriteSpan<Pixel::NORMAL>(pDst, nCount, nStride, p); return true;
+		case Pixel::MASK: olc_WriteSpan<Pixel::MASK>(pDst, nCount, nStride, p); return true;
+		case Pixel::ALPHA: olc_WriteSpan<Pixel::ALPHA>(pDst, nCount, nStride, p); return true;
+		default: return false;
+		}
+	}
+
+	void PixelGameEngine::DrawSpan(int32_t x1, int32_t x2, int32_t y, Pixel p)
+	{
+		if (!pDrawTarget) return;
+
+		if (nPixelMode == Pixel::CUSTOM)
+		{
+			for (int32_t x = x1; x <= x2; x++) Draw(x, y, p);
+			return;
+		}
+
+		if (y < 0 || y >= pDrawTarget->height) return;
+		if (x1 < 0) x1 = 0;
+		if (x2 >= pDrawTarget->width) x2 = pDrawTarget->width - 1;
+		if (x2 < x1) return;
+
+		olc_WriteSpan(pDrawTarget->pColData.data() + y * pDrawTarget->width + x1, x2 - x1 + 1, 1, p);
+		pDrawTarget->MarkDirty(x1, y, x2 - x1 + 1, 1);
+	}
+
 
 	void PixelGameEngine::DrawLine(const olc::vi2d& pos1, const olc::vi2d& pos2, Pixel p, uint32_t pattern)
 	{ DrawLine(pos1.x, pos1.y, pos2.x, pos2.y, p, pattern); }
@@ -2004,6 +2331,19 @@ namespace olc
 		if (dx == 0) // Line is vertical
 		{
 			if (y2 < y1) std::swap(y1, y2);
+
+			// Solid lines are clipped once and written straight down the column
+			if (pattern == 0xFFFFFFFF && nPixelMode != Pixel::CUSTOM && pDrawTarget)
+			{
+				if (x1 < 0 || x1 >= pDrawTarget->width) return;
+				if (y1 < 0) y1 = 0;
+				if (y2 >= pDrawTarget->height) y2 = pDrawTarget->height - 1;
+				if (y2 < y1) return;
+				olc_WriteSpan(pDrawTarget->pColData.data() + y1 * pDrawTarget->width + x1, y2 - y1 + 1, pDrawTarget->width, p);
+				pDrawTarget->MarkDirty(x1, y1, 1, y2 - y1 + 1);
+				return;
+			}
+
 			for (y = y1; y <= y2; y++) if (rol()) Draw(x1, y, p);
 			return;
 		}
@@ -2011,6 +2351,13 @@ namespace olc
 		if (dy == 0) // Line is horizontal
 		{
 			if (x2 < x1) std::swap(x1, x2);
+
+			if (pattern == 0xFFFFFFFF)
+			{
+				DrawSpan(x1, x2, y1, p);
+				return;
+			}
+
 			for (x = x1; x <= x2; x++) if (rol()) Draw(x, y1, p);
 			return;
 		}
@@ -2127,8 +2474,7 @@ namespace olc
 
 			auto drawline = [&](int sx, int ex, int y)
 			{
-				for (int x = sx; x <= ex; x++)
-					Draw(x, y, p);
+				DrawSpan(sx, ex, y, p);
 			};
 
 			while (y0 >= x0)
@@ -2166,9 +2512,10 @@ namespace olc
 
 	void PixelGameEngine::Clear(Pixel p)
 	{
-		int pixels = GetDrawTargetWidth() * GetDrawTargetHeight();
-		Pixel* m = GetDrawTarget()->GetData();
-		for (int i = 0; i < pixels; i++) m[i] = p;
+		size_t pixels = (size_t)GetDrawTargetWidth() * (size_t)GetDrawTargetHeight();
+		span::Fill(GetDrawTarget()->pColData.data(), pixels, p, pixels >= span::nStreamThreshold);
+		span::Fence();
+		GetDrawTarget()->MarkDirty();
 	}
 
 	void PixelGameEngine::ClearBuffer(Pixel p, bool bDepth)
@@ -2234,9 +2581,36 @@ namespace olc
 		if (y2 < 0) y2 = 0;
 		if (y2 >= (int32_t)GetDrawTargetHeight()) y2 = (int32_t)GetDrawTargetHeight();
 
-		for (int i = x; i < x2; i++)
-			for (int j = y; j < y2; j++)
-				Draw(i, j, p);
+		if (x >= x2 || y >= y2) return;
+
+		// Colours that end up fully opaque are plain fills. Rectangles as wide as
+		// the target are one run, which skips the cache once it reaches the stream
+		// threshold. At 1280 pixels wide that takes over 200 rows, a strip such as a
+		// 100 row control area stays in the cache
+		bool bOpaque = nPixelMode == Pixel::NORMAL
+			|| (nPixelMode == Pixel::MASK && p.a == 255)
+			|| (nPixelMode == Pixel::ALPHA && blend::Alpha(p.a, nBlendFactor) == 255);
+
+		if (bOpaque)
+		{
+			int32_t nWidth = pDrawTarget->width;
+			Pixel* pRow = pDrawTarget->pColData.data() + y * nWidth + x;
+			pDrawTarget->MarkDirty(x, y, x2 - x, y2 - y);
+			if (x == 0 && x2 == nWidth)
+			{
+				size_t nCount = (size_t)nWidth * (size_t)(y2 - y);
+				span::Fill(pRow, nCount, p, nCount >= span::nStreamThreshold);
+				span::Fence();
+			}
+			else
+				for (int j = y; j < y2; j++, pRow += nWidth)
+					span::Fill(pRow, (size_t)(x2 - x), p, false);
+			return;
+		}
+
+		// Row by row, so memory is written in order
+		for (int j = y; j < y2; j++)
+			DrawSpan(x, x2 - 1, j, p);
 	}
 
 	void PixelGameEngine::DrawTriangle(const olc::vi2d& pos1, const olc::vi2d& pos2, const olc::vi2d& pos3, Pixel p)
@@ -2255,7 +2629,7 @@ namespace olc
 	// https://www.avrfreaks.net/sites/default/files/triangles.c
 	void PixelGameEngine::FillTriangle(int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t x3, int32_t y3, Pixel p)
 	{
-		auto drawline = [&](int sx, int ex, int ny) { for (int i = sx; i <= ex; i++) Draw(i, ny, p); };
+		auto drawline = [&](int sx, int ex, int ny) { DrawSpan(sx, ex, ny, p); };
 
 		int t1x, t2x, y, minx, maxx, t1xp, t2xp;
 		bool changed1 = false;
@@ -2413,7 +2787,7 @@ namespace olc
 							Draw(x + (i * scale) + is, y + (j * scale) + js, sprite->GetPixel(fx, fy));
 			}
 		}
-		else
+		else if (!olc_DrawSpriteRows(x, y, sprite, 0, 0, sprite->width, sprite->height, flip))
 		{
 			fx = fxs;
 			for (int32_t i = 0; i < sprite->width; i++, fx += fxm)
@@ -2450,7 +2824,7 @@ namespace olc
 							Draw(x + (i * scale) + is, y + (j * scale) + js, sprite->GetPixel(fx + ox, fy + oy));
 			}
 		}
-		else
+		else if (!olc_DrawSpriteRows(x, y, sprite, ox, oy, w, h, flip))
 		{
 			fx = fxs;
 			for (int32_t i = 0; i < w; i++, fx += fxm)
@@ -2462,6 +2836,52 @@ namespace olc
 		}
 	}
 
+	DecalInstance& PixelGameEngine::olc_NewDecalInstance()
+	{
+		LayerDesc& layer = vLayers[nTargetLayer];
+		if (layer.nDecalInstances == layer.vecDecalInstance.size())
+			layer.vecDecalInstance.emplace_back();
+
+		DecalInstance& di = layer.vecDecalInstance[layer.nDecalInstances++];
+		di.decal = nullptr;
+		di.pos.clear(); di.uv.clear(); di.w.clear(); di.tint.clear();
+		di.mode = olc::DecalMode::NORMAL;
+		di.structure = olc::DecalStructure::FAN;
+		di.points = 0;
+		return di;
+	}
+
+	bool PixelGameEngine::olc_DrawSpriteRows(int32_t x, int32_t y, Sprite* sprite, int32_t ox, int32_t oy, int32_t w, int32_t h, uint8_t flip)
+	{
+		// Mirrored rows, custom modes and regions outside the sprite (which wrap or
+		// clamp depending on its sample mode) are left to the per pixel path
+		if (!pDrawTarget || nPixelMode == Pixel::CUSTOM || (flip & olc::Sprite::Flip::HORIZ)) return false;
+		if (ox < 0 || oy < 0 || ox + w > sprite->width || oy + h > sprite->height) return false;
+
+		// Clip the destination once
+		int32_t sx = std::max(0, -x), sy = std::max(0, -y);
+		int32_t ex = std::min(w, pDrawTarget->width - x), ey = std::min(h, pDrawTarget->height - y);
+		if (sx >= ex || sy >= ey) return true;
+
+		for (int32_t j = sy; j < ey; j++)
+		{
+			int32_t fy = (flip & olc::Sprite::Flip::VERT) ? h - 1 - j : j;
+			const Pixel* pSrc = sprite->pColData.data() + (fy + oy) * sprite->width + ox + sx;
+			Pixel* pDst = pDrawTarget->pColData.data() + (y + j) * pDrawTarget->width + x + sx;
+			int32_t nCount = ex - sx;
+
+			if (nPixelMode == Pixel::NORMAL)
+				std::copy_n(pSrc, nCount, pDst);
+			else if (nPixelMode == Pixel::MASK)
+				for (int32_t i = 0; i < nCount; i++) { if (pSrc[i].a == 255) pDst[i] = pSrc[i]; }
+			else
+				blend::SourceSpan(pDst, pSrc, nCount, nBlendFactor);
+		}
+
+		pDrawTarget->MarkDirty(x + sx, y + sy, ex - sx, ey - sy);
+		return true;
+	}
+
 	void PixelGameEngine::SetDecalMode(const olc::DecalMode& mode)
 	{ nDecalMode = mode; }
 
@@ -2487,7 +2907,7 @@ namespace olc
 		olc::vf2d vQuantisedPos = ((vScreenSpacePos * vWindow) + olc::vf2d(0.5f, 0.5f)).floor() / vWindow;
 		olc::vf2d vQuantisedDim = ((vScreenSpaceDim * vWindow) + olc::vf2d(0.5f, -0.5f)).ceil() / vWindow;
 
-		DecalInstance di;
+		DecalInstance& di = olc_NewDecalInstance();
 		di.points = 4;
 		di.decal = decal;
 		di.tint = { tint, tint, tint, tint };
@@ -2498,7 +2918,6 @@ namespace olc
 		di.w = { 1,1,1,1 };
 		di.mode = nDecalMode;
 		di.structure = nDecalStructure;
-		vLayers[nTargetLayer].vecDecalInstance.push_back(di);
 	}
 
 	void PixelGameEngine::DrawPartialDecal(const olc::vf2d& pos, const olc::vf2d& size, olc::Decal* decal, const olc::vf2d& source_pos, const olc::vf2d& source_size, const olc::Pixel& tint)
@@ -2515,7 +2934,7 @@ namespace olc
 			vScreenSpacePos.y - (2.0f * size.y * vInvScreenSize.y)
 		};
 
-		DecalInstance di;
+		DecalInstance& di = olc_NewDecalInstance();
 		di.points = 4;
 		di.decal = decal;
 		di.tint = { tint, tint, tint, tint };
@@ -2526,7 +2945,6 @@ namespace olc
 		di.w = { 1,1,1,1 };
 		di.mode = nDecalMode;
 		di.structure = nDecalStructure;
-		vLayers[nTargetLayer].vecDecalInstance.push_back(di);
 	}
 
 
@@ -2544,7 +2962,7 @@ namespace olc
 			vScreenSpacePos.y - (2.0f * (float(decal->sprite->height) * vInvScreenSize.y)) * scale.y
 		};
 
-		DecalInstance di;
+		DecalInstance& di = olc_NewDecalInstance();
 		di.decal = decal;
 		di.points = 4;
 		di.tint = { tint, tint, tint, tint };
@@ -2553,12 +2971,11 @@ namespace olc
 		di.w = { 1, 1, 1, 1 };
 		di.mode = nDecalMode;
 		di.structure = nDecalStructure;
-		vLayers[nTargetLayer].vecDecalInstance.push_back(di);
 	}
 
 	void PixelGameEngine::DrawExplicitDecal(olc::Decal* decal, const olc::vf2d* pos, const olc::vf2d* uv, const olc::Pixel* col, uint32_t elements)
 	{
-		DecalInstance di;
+		DecalInstance& di = olc_NewDecalInstance();
 		di.decal = decal;
 		di.pos.resize(elements);
 		di.uv.resize(elements);
@@ -2574,12 +2991,11 @@ namespace olc
 		}
 		di.mode = nDecalMode;
 		di.structure = nDecalStructure;
-		vLayers[nTargetLayer].vecDecalInstance.push_back(di);
 	}
 
 	void PixelGameEngine::DrawPolygonDecal(olc::Decal* decal, const std::vector<olc::vf2d>& pos, const std::vector<olc::vf2d>& uv, const olc::Pixel tint)
 	{
-		DecalInstance di;
+		DecalInstance& di = olc_NewDecalInstance();
 		di.decal = decal;
 		di.points = uint32_t(pos.size());
 		di.pos.resize(di.points);
@@ -2595,12 +3011,11 @@ namespace olc
 		}
 		di.mode = nDecalMode;
 		di.structure = nDecalStructure;
-		vLayers[nTargetLayer].vecDecalInstance.push_back(di);
 	}
 
 	void PixelGameEngine::DrawPolygonDecal(olc::Decal* decal, const std::vector<olc::vf2d>& pos, const std::vector<olc::vf2d>& uv, const std::vector<olc::Pixel> &tint)
 	{
-		DecalInstance di;
+		DecalInstance& di = olc_NewDecalInstance();
 		di.decal = decal;
 		di.points = uint32_t(pos.size());
 		di.pos.resize(di.points);
@@ -2616,12 +3031,11 @@ namespace olc
 		}
 		di.mode = nDecalMode;
 		di.structure = nDecalStructure;
-		vLayers[nTargetLayer].vecDecalInstance.push_back(di);
 	}
 
 	void PixelGameEngine::DrawPolygonDecal(olc::Decal* decal, const std::vector<olc::vf2d>& pos, const std::vector<float>& depth, const std::vector<olc::vf2d>& uv, const olc::Pixel tint)
 	{
-		DecalInstance di;
+		DecalInstance& di = olc_NewDecalInstance();
 		di.decal = decal;
 		di.points = uint32_t(pos.size());
 		di.pos.resize(di.points);
@@ -2637,14 +3051,13 @@ namespace olc
 		}
 		di.mode = nDecalMode;
 		di.structure = nDecalStructure;
-		vLayers[nTargetLayer].vecDecalInstance.push_back(di);
 	}
 
 #ifdef OLC_ENABLE_EXPERIMENTAL
 	// Lightweight 3D
 	void PixelGameEngine::LW3D_DrawTriangles(olc::Decal* decal, const std::vector<std::array<float, 3>>& pos, const std::vector<olc::vf2d>& tex, const std::vector<olc::Pixel>& col)
 	{
-		DecalInstance di;
+		DecalInstance& di = olc_NewDecalInstance();
 		di.decal = decal;
 		di.points = uint32_t(pos.size());
 		di.pos.resize(di.points);
@@ -2659,13 +3072,12 @@ namespace olc
 			di.tint[i] = col[i];			
 		}
 		di.mode = DecalMode::MODEL3D;
-		vLayers[nTargetLayer].vecDecalInstance.push_back(di);
 	}
 #endif
 
 	void PixelGameEngine::DrawLineDecal(const olc::vf2d& pos1, const olc::vf2d& pos2, Pixel p)
 	{
-		DecalInstance di;
+		DecalInstance& di = olc_NewDecalInstance();
 		di.decal = nullptr;
 		di.points = uint32_t(2);
 		di.pos.resize(di.points);
@@ -2681,7 +3093,6 @@ namespace olc
 		di.tint[1] = p;
 		di.w[1] = 1.0f;
 		di.mode = olc::DecalMode::WIREFRAME;
-		vLayers[nTargetLayer].vecDecalInstance.push_back(di);
 	}
 
 	void PixelGameEngine::FillRectDecal(const olc::vf2d& pos, const olc::vf2d& size, const olc::Pixel col)
@@ -2703,7 +3114,7 @@ namespace olc
 
 	void PixelGameEngine::DrawRotatedDecal(const olc::vf2d& pos, olc::Decal* decal, const float fAngle, const olc::vf2d& center, const olc::vf2d& scale, const olc::Pixel& tint)
 	{
-		DecalInstance di;
+		DecalInstance& di = olc_NewDecalInstance();
 		di.decal = decal;
 		di.pos.resize(4);
 		di.uv = { { 0.0f, 0.0f}, {0.0f, 1.0f}, {1.0f, 1.0f}, {1.0f, 0.0f} };
@@ -2724,13 +3135,12 @@ namespace olc
 		}
 		di.mode = nDecalMode;
 		di.structure = nDecalStructure;
-		vLayers[nTargetLayer].vecDecalInstance.push_back(di);
 	}
 
 
 	void PixelGameEngine::DrawPartialRotatedDecal(const olc::vf2d& pos, olc::Decal* decal, const float fAngle, const olc::vf2d& center, const olc::vf2d& source_pos, const olc::vf2d& source_size, const olc::vf2d& scale, const olc::Pixel& tint)
 	{
-		DecalInstance di;
+		DecalInstance& di = olc_NewDecalInstance();
 		di.decal = decal;
 		di.points = 4;
 		di.tint = { tint, tint, tint, tint };
@@ -2753,12 +3163,11 @@ namespace olc
 		di.uv = { { uvtl.x, uvtl.y }, { uvtl.x, uvbr.y }, { uvbr.x, uvbr.y }, { uvbr.x, uvtl.y } };
 		di.mode = nDecalMode;
 		di.structure = nDecalStructure;
-		vLayers[nTargetLayer].vecDecalInstance.push_back(di);
 	}
 
 	void PixelGameEngine::DrawPartialWarpedDecal(olc::Decal* decal, const olc::vf2d* pos, const olc::vf2d& source_pos, const olc::vf2d& source_size, const olc::Pixel& tint)
 	{
-		DecalInstance di;
+		DecalInstance& di = olc_NewDecalInstance();
 		di.points = 4;
 		di.decal = decal;
 		di.tint = { tint, tint, tint, tint };
@@ -2786,15 +3195,16 @@ namespace olc
 			}
 			di.mode = nDecalMode;
 			di.structure = nDecalStructure;
-			vLayers[nTargetLayer].vecDecalInstance.push_back(di);
 		}
+		else
+			vLayers[nTargetLayer].nDecalInstances--;
 	}
 
 	void PixelGameEngine::DrawWarpedDecal(olc::Decal* decal, const olc::vf2d* pos, const olc::Pixel& tint)
 	{
 		// Thanks Nathan Reed, a brilliant article explaining whats going on here
 		// http://www.reedbeta.com/blog/quadrilateral-interpolation-part-1/
-		DecalInstance di;
+		DecalInstance& di = olc_NewDecalInstance();
 		di.points = 4;
 		di.decal = decal;
 		di.tint = { tint, tint, tint, tint };
@@ -2818,8 +3228,9 @@ namespace olc
 			}
 			di.mode = nDecalMode;
 			di.structure = nDecalStructure;
-			vLayers[nTargetLayer].vecDecalInstance.push_back(di);
 		}
+		else
+			vLayers[nTargetLayer].nDecalInstances--;
 	}
 
 	void PixelGameEngine::DrawWarpedDecal(olc::Decal* decal, const std::array<olc::vf2d, 4>& pos, const olc::Pixel& tint)
@@ -3077,6 +3488,7 @@ namespace olc
 		fBlendFactor = fBlend;
 		if (fBlendFactor < 0.0f) fBlendFactor = 0.0f;
 		if (fBlendFactor > 1.0f) fBlendFactor = 1.0f;
+		nBlendFactor = (uint32_t)(fBlendFactor * 255.0f + 0.5f);
 	}
 
 	std::stringstream& PixelGameEngine::ConsoleOut()
@@ -3368,6 +3780,9 @@ namespace olc
 	void PixelGameEngine::olc_Terminate()
 	{ bAtomActive = false; }
 
+	void PixelGameEngine::olc_SetFixedElapsedTime(float fElapsedTime)
+	{ fFixedElapsedTime = fElapsedTime; }
+
 	void PixelGameEngine::EngineThread()
 	{
 		// Allow platform to do stuff here if needed, since its now in the
@@ -3425,7 +3840,7 @@ namespace olc
 		m_tp1 = m_tp2;
 
 		// Our time per frame coefficient
-		float fElapsedTime = elapsedTime.count();
+		float fElapsedTime = fFixedElapsedTime > 0.0f ? fFixedElapsedTime : elapsedTime.count();
 		fLastElapsed = fElapsedTime;
 
 		if (bConsoleSuspendTime)
@@ -3505,6 +3920,7 @@ namespace olc
 					renderer->ApplyTexture(layer->pDrawTarget.Decal()->id);
 					if (!bSuspendTextureTransfer && layer->bUpdate)
 					{
+						OLC_PROFILE_ZONE("LayerUpload");
 						layer->pDrawTarget.Decal()->Update();
 						layer->bUpdate = false;
 					}
@@ -3512,9 +3928,9 @@ namespace olc
 					renderer->DrawLayerQuad(layer->vOffset, layer->vScale, layer->tint);
 
 					// Display Decals in order for this layer
-					for (auto& decal : layer->vecDecalInstance)
-						renderer->DrawDecal(decal);
-					layer->vecDecalInstance.clear();
+					if (layer->nDecalInstances > 0)
+						renderer->DrawDecals(layer->vecDecalInstance.data(), layer->nDecalInstances);
+					layer->nDecalInstances = 0;
 				}
 				else
 				{
@@ -3527,7 +3943,10 @@ namespace olc
 		
 
 		// Present Graphics to screen
-		renderer->DisplayFrame();
+		{
+			OLC_PROFILE_ZONE("DisplayFrame");
+			renderer->DisplayFrame();
+		}
 
 		// Update Title Bar
 		fFrameTimer += fElapsedTime;
@@ -4009,12 +4428,24 @@ namespace olc
 		void UpdateTexture(uint32_t id, olc::Sprite* spr) override
 		{
 			UNUSED(id);
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, spr->width, spr->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, spr->GetData());
+			if (!spr->IsDirty()) return;
+
+			if (spr->IsFullyDirty())
+			{
+				glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, spr->width, spr->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, spr->pColData.data());
+				return;
+			}
+
+			// Only the rectangle written since the last upload, read out of the full rows of the sprite
+			olc::vi2d vPos = spr->vDirtyMin, vSize = spr->vDirtyMax - spr->vDirtyMin;
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, spr->width);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, vPos.x, vPos.y, vSize.x, vSize.y, GL_RGBA, GL_UNSIGNED_BYTE, spr->pColData.data() + vPos.y * spr->width + vPos.x);
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 		}
 
 		void ReadTexture(uint32_t id, olc::Sprite* spr) override
 		{
-			glReadPixels(0, 0, spr->width, spr->height, GL_RGBA, GL_UNSIGNED_BYTE, spr->GetData());
+			glReadPixels(0, 0, spr->width, spr->height, GL_RGBA, GL_UNSIGNED_BYTE, spr->pColData.data());
 		}
 
 		void ApplyTexture(uint32_t id) override
@@ -4120,9 +4551,25 @@ namespace olc
 	typedef void CALLSTYLE locBindVertexArray_t(GLuint array);
 	typedef void CALLSTYLE locGenVertexArrays_t(GLsizei n, GLuint* arrays);
 	typedef void CALLSTYLE locGetShaderInfoLog_t(GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog);
+#if !defined(OLC_PLATFORM_EMSCRIPTEN)
+	typedef ptrdiff_t GLintptr;
+	typedef struct locSync* locSync_t;
+	typedef void CALLSTYLE locDeleteBuffers_t(GLsizei n, const GLuint* buffers);
+	typedef void CALLSTYLE locBufferStorage_t(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+	typedef void* CALLSTYLE locMapBufferRange_t(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+	typedef GLboolean CALLSTYLE locUnmapBuffer_t(GLenum target);
+	typedef locSync_t CALLSTYLE locFenceSync_t(GLenum condition, GLbitfield flags);
+	typedef GLenum CALLSTYLE locClientWaitSync_t(locSync_t sync, GLbitfield flags, uint64_t timeout);
+	typedef void CALLSTYLE locDeleteSync_t(locSync_t sync);
+	typedef const GLubyte* CALLSTYLE locGetStringi_t(GLenum name, GLuint index);
+#endif
 
 	constexpr size_t OLC_MAX_VERTS = 128;
 
+	// Texture uploads of at least this many bytes are streamed through pixel buffer objects
+	constexpr size_t OLC_PBO_MIN_BYTES = 64 * 1024;
+	constexpr size_t OLC_PBO_SLOTS = 3;
+
 	class Renderer_OGL33 : public olc::Renderer
 	{
 	private:
@@ -4168,12 +4615,24 @@ namespace olc
 		locGenVertexArrays_t* locGenVertexArrays = nullptr;
 		locSwapInterval_t* locSwapInterval = nullptr;
 		locGetShaderInfoLog_t* locGetShaderInfoLog = nullptr;
+#if !defined(OLC_PLATFORM_EMSCRIPTEN)
+		locDeleteBuffers_t* locDeleteBuffers = nullptr;
+		locBufferStorage_t* locBufferStorage = nullptr;
+		locMapBufferRange_t* locMapBufferRange = nullptr;
+		locUnmapBuffer_t* locUnmapBuffer = nullptr;
+		locFenceSync_t* locFenceSync = nullptr;
+		locClientWaitSync_t* locClientWaitSync = nullptr;
+		locDeleteSync_t* locDeleteSync = nullptr;
+		locGetStringi_t* locGetStringi = nullptr;
+#endif
 
 		uint32_t m_nFS = 0;
 		uint32_t m_nVS = 0;
 		uint32_t m_nQuadShader = 0;
 		uint32_t m_vbQuad = 0;
 		uint32_t m_vaQuad = 0;
+		uint32_t m_vbBatch = 0;
+		uint32_t m_vaBatch = 0;
 
 		struct locVertex
 		{
@@ -4184,8 +4643,42 @@ namespace olc
 
 		locVertex pVertexMem[OLC_MAX_VERTS];
 
+		// Consecutive decals sharing texture, mode and primitive form one batch. All batches
+		// of a layer are packed into one vertex buffer, uploaded once and drawn with one call
+		// each. Decals are never reordered, as that would change how they blend.
+		struct locBatch
+		{
+			GLuint nTexture;
+			olc::DecalMode mode;
+			GLenum nPrimitive;
+			GLint nFirst;
+			GLsizei nCount;
+		};
+
+		std::vector<locVertex> vBatchVertices;
+		std::vector<locBatch> vBatches;
+
 		olc::Renderable rendBlankQuad;
 
+#if !defined(OLC_PLATFORM_EMSCRIPTEN)
+		// Large texture uploads go through a ring of pixel buffer objects, so glTexSubImage2D
+		// returns at once and the driver copies into the texture while the next frame is
+		// drawn. A slot is only written again once the fence set after its last use passed.
+		// With GL 4.4 / ARB_buffer_storage the slots stay mapped for their whole lifetime,
+		// otherwise they are mapped for every write.
+		struct locPixelBuffer
+		{
+			GLuint id = 0;
+			size_t nBytes = 0;
+			uint8_t* pMapped = nullptr;
+			locSync_t fence = nullptr;
+		};
+
+		std::array<locPixelBuffer, OLC_PBO_SLOTS> vPixelBuffers;
+		size_t nPixelBuffer = 0;
+		bool bPixelBuffers = false;
+#endif
+
 	public:
 		void PrepareDevice() override
 		{
@@ -4316,6 +4809,22 @@ namespace olc
 			locBindVertexArray = glBindVertexArrayOES;
 			locGenVertexArrays = glGenVertexArraysOES;
 #endif
+#if !defined(OLC_PLATFORM_EMSCRIPTEN)
+			locDeleteBuffers = OGL_LOAD(locDeleteBuffers_t, glDeleteBuffers);
+			locBufferStorage = OGL_LOAD(locBufferStorage_t, glBufferStorage);
+			locMapBufferRange = OGL_LOAD(locMapBufferRange_t, glMapBufferRange);
+			locUnmapBuffer = OGL_LOAD(locUnmapBuffer_t, glUnmapBuffer);
+			locFenceSync = OGL_LOAD(locFenceSync_t, glFenceSync);
+			locClientWaitSync = OGL_LOAD(locClientWaitSync_t, glClientWaitSync);
+			locDeleteSync = OGL_LOAD(locDeleteSync_t, glDeleteSync);
+			locGetStringi = OGL_LOAD(locGetStringi_t, glGetStringi);
+
+			// Some loaders hand out stubs for every name, so the version has to vouch for it
+			if (!HasBufferStorage()) locBufferStorage = nullptr;
+	#if !defined(OLC_GL_NO_PBO)
+			bPixelBuffers = locMapBufferRange && locUnmapBuffer && locFenceSync && locClientWaitSync && locDeleteSync && locDeleteBuffers;
+	#endif
+#endif
 
 			// Load & Compile Quad Shader - assumes no errors
 			m_nFS = locCreateShader(0x8B30);
@@ -4364,6 +4873,18 @@ namespace olc
 			locBindBuffer(0x8892, 0);
 			locBindVertexArray(0);
 
+			// Create the buffer decal batches are streamed into
+			locGenBuffers(1, &m_vbBatch);
+			locGenVertexArrays(1, &m_vaBatch);
+			locBindVertexArray(m_vaBatch);
+			locBindBuffer(0x8892, m_vbBatch);
+			locBufferData(0x8892, sizeof(locVertex) * OLC_MAX_VERTS, nullptr, 0x88E0);
+			locVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(locVertex), 0); locEnableVertexAttribArray(0);
+			locVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(locVertex), (void*)(3 * sizeof(float))); locEnableVertexAttribArray(1);
+			locVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(locVertex), (void*)(5 * sizeof(float)));	locEnableVertexAttribArray(2);
+			locBindBuffer(0x8892, 0);
+			locBindVertexArray(0);
+
 			// Create blank texture for spriteless decals
 			rendBlankQuad.Create(1, 1);
 			rendBlankQuad.Sprite()->GetData()[0] = olc::WHITE;
@@ -4373,6 +4894,10 @@ namespace olc
 
 		olc::rcode DestroyDevice() override
 		{
+#if !defined(OLC_PLATFORM_EMSCRIPTEN)
+			for (auto& pbo : vPixelBuffers) ReleasePixelBuffer(pbo);
+#endif
+
 #if defined(OLC_PLATFORM_WINAPI)
 			wglDeleteContext(glRenderContext);
 #endif
@@ -4486,6 +5011,84 @@ namespace olc
 				glDrawArrays(GL_TRIANGLE_FAN, 0, decal.points);
 		}
 
+		void DrawDecals(const olc::DecalInstance* decals, size_t count) override
+		{
+			vBatchVertices.clear();
+			vBatches.clear();
+
+			for (size_t n = 0; n < count; n++)
+			{
+				const olc::DecalInstance& decal = decals[n];
+				const GLuint nTexture = (decal.decal == nullptr) ? rendBlankQuad.Decal()->id : decal.decal->id;
+				const GLenum nPrimitive = (decal.mode == DecalMode::WIREFRAME) ? GL_LINES : GL_TRIANGLES;
+				const GLint nFirst = GLint(vBatchVertices.size());
+
+				auto vertex = [&](uint32_t i)
+				{ vBatchVertices.push_back({ { decal.pos[i].x, decal.pos[i].y, decal.w[i] }, { decal.uv[i].x, decal.uv[i].y }, decal.tint[i] }); };
+
+				// Everything becomes a list, so that any number of decals fit one draw call
+				if (nPrimitive == GL_LINES)
+				{
+					// The edges a line loop would draw, including the closing one
+					for (uint32_t i = 0; i < decal.points; i++) { vertex(i); vertex((i + 1) % decal.points); }
+				}
+				else if (decal.structure == olc::DecalStructure::LIST)
+				{
+					for (uint32_t i = 0; i + 2 < decal.points; i += 3) { vertex(i); vertex(i + 1); vertex(i + 2); }
+				}
+				else if (decal.structure == olc::DecalStructure::STRIP)
+				{
+					// Every other triangle is flipped to keep the winding of the strip
+					for (uint32_t i = 0; i + 2 < decal.points; i++)
+					{
+						if (i & 1) { vertex(i + 1); vertex(i); vertex(i + 2); }
+						else { vertex(i); vertex(i + 1); vertex(i + 2); }
+					}
+				}
+				else
+				{
+					for (uint32_t i = 1; i + 1 < decal.points; i++) { vertex(0); vertex(i); vertex(i + 1); }
+				}
+
+				const GLsizei nCount = GLsizei(vBatchVertices.size()) - nFirst;
+				if (nCount == 0) continue;
+
+				if (!vBatches.empty() && vBatches.back().nTexture == nTexture && vBatches.back().mode == decal.mode && vBatches.back().nPrimitive == nPrimitive)
+					vBatches.back().nCount += nCount;
+				else
+					vBatches.push_back({ nTexture, decal.mode, nPrimitive, nFirst, nCount });
+			}
+
+			if (vBatches.empty()) return;
+
+			// Respecifying the whole store lets the driver hand out fresh memory instead of
+			// waiting for the draws of the previous layer to finish with it
+			locBindVertexArray(m_vaBatch);
+			locBindBuffer(0x8892, m_vbBatch);
+			locBufferData(0x8892, sizeof(locVertex) * vBatchVertices.size(), vBatchVertices.data(), 0x88E0);
+#if defined(OLC_PLATFORM_EMSCRIPTEN)
+			locVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(locVertex), 0); locEnableVertexAttribArray(0);
+			locVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(locVertex), (void*)(3 * sizeof(float))); locEnableVertexAttribArray(1);
+			locVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(locVertex), (void*)(5 * sizeof(float)));	locEnableVertexAttribArray(2);
+#endif
+
+			for (const auto& batch : vBatches)
+			{
+				SetDecalMode(batch.mode);
+				glBindTexture(GL_TEXTURE_2D, batch.nTexture);
+				glDrawArrays(batch.nPrimitive, batch.nFirst, batch.nCount);
+			}
+
+			// The layer quads and single decals draw from the quad buffer
+			locBindVertexArray(m_vaQuad);
+			locBindBuffer(0x8892, m_vbQuad);
+#if defined(OLC_PLATFORM_EMSCRIPTEN)
+			locVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(locVertex), 0); locEnableVertexAttribArray(0);
+			locVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(locVertex), (void*)(3 * sizeof(float))); locEnableVertexAttribArray(1);
+			locVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(locVertex), (void*)(5 * sizeof(float)));	locEnableVertexAttribArray(2);
+#endif
+		}
+
 		uint32_t CreateTexture(const uint32_t width, const uint32_t height, const bool filtered, const bool clamp) override
 		{
 			UNUSED(width);
@@ -4530,41 +5133,217 @@ namespace olc
 		void UpdateTexture(uint32_t id, olc::Sprite* spr) override
 		{
 			UNUSED(id);
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, spr->width, spr->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, spr->GetData());
-		}
+			if (!spr->IsDirty()) return;
 
-		void ReadTexture(uint32_t id, olc::Sprite* spr) override
-		{
-			glReadPixels(0, 0, spr->width, spr->height, GL_RGBA, GL_UNSIGNED_BYTE, spr->GetData());
-		}
+			if (spr->IsFullyDirty())
+			{
+#if !defined(OLC_PLATFORM_EMSCRIPTEN)
+				if (StreamTexture(spr, { 0, 0 }, { spr->width, spr->height }, true)) return;
+#endif
+				glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, spr->width, spr->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, spr->pColData.data());
+				return;
+			}
 
-		void ApplyTexture(uint32_t id) override
-		{
-			glBindTexture(GL_TEXTURE_2D, id);
+			olc::vi2d vPos = spr->vDirtyMin, vSize = spr->vDirtyMax - spr->vDirtyMin;
+#if defined(OLC_PLATFORM_EMSCRIPTEN)
+			// WebGL 1 cannot skip into a row, so whole rows of the dirty band are sent
+			vPos.x = 0; vSize.x = spr->width;
+#else
+			if (StreamTexture(spr, vPos, vSize, false)) return;
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, spr->width);
+#endif
+			glTexSubImage2D(GL_TEXTURE_2D, 0, vPos.x, vPos.y, vSize.x, vSize.y, GL_RGBA, GL_UNSIGNED_BYTE, spr->pColData.data() + vPos.y * spr->width + vPos.x);
+#if !defined(OLC_PLATFORM_EMSCRIPTEN)
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+#endif
 		}
 
-		void ClearBuffer(olc::Pixel p, bool bDepth) override
+#if !defined(OLC_PLATFORM_EMSCRIPTEN)
+	private:
+		// Copies a rectangle of the sprite into the next pixel buffer and has the texture
+		// updated from there. Returns false if the caller has to upload it directly.
+		bool StreamTexture(olc::Sprite* spr, const olc::vi2d& vPos, const olc::vi2d& vSize, bool bRespecify)
 		{
-			glClearColor(float(p.r) / 255.0f, float(p.g) / 255.0f, float(p.b) / 255.0f, float(p.a) / 255.0f);
-			glClear(GL_COLOR_BUFFER_BIT);
-			if (bDepth) glClear(GL_DEPTH_BUFFER_BIT);
-		}
+			const size_t nRowBytes = size_t(vSize.x) * sizeof(olc::Pixel);
+			const size_t nBytes = nRowBytes * size_t(vSize.y);
+			if (!bPixelBuffers || nBytes < OLC_PBO_MIN_BYTES) return false;
 
-		void UpdateViewport(const olc::vi2d& pos, const olc::vi2d& size) override
-		{
-			glViewport(pos.x, pos.y, size.x, size.y);
-		}
-	};
-}
-#endif
-// O------------------------------------------------------------------------------O
-// | END RENDERER: OpenGL 3.3 (3.0 es) (sh-sh-sh-shaders....)                     |
-// O------------------------------------------------------------------------------O
-#pragma endregion
+			locPixelBuffer& pbo = vPixelBuffers[nPixelBuffer];
+			nPixelBuffer = (nPixelBuffer + 1) % OLC_PBO_SLOTS;
 
-// O------------------------------------------------------------------------------O
-// | olcPixelGameEngine Image loaders                                             |
-// O------------------------------------------------------------------------------O
+			// Waits for the driver to have finished reading what was put here OLC_PBO_SLOTS uploads ago
+			if (pbo.fence != nullptr)
+			{
+				// GL_SYNC_FLUSH_COMMANDS_BIT, looping while GL_TIMEOUT_EXPIRED
+				while (locClientWaitSync(pbo.fence, 0x00000001, 1000000) == 0x911B) {}
+				locDeleteSync(pbo.fence);
+				pbo.fence = nullptr;
+			}
+
+			// Buffers are sized for the whole sprite, so a growing dirty area does not recreate them
+			if (pbo.nBytes < nBytes && !CreatePixelBuffer(pbo, std::max(nBytes, size_t(spr->width) * size_t(spr->height) * sizeof(olc::Pixel))))
+			{
+				ReleasePixelBuffer(pbo);
+				bPixelBuffers = false;
+				return false;
+			}
+
+			locBindBuffer(0x88EC, pbo.id);
+
+			// GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT, the fence
+			// above already made sure the driver is done with this buffer
+			uint8_t* pDst = pbo.pMapped;
+			if (pDst == nullptr)
+				pDst = (uint8_t*)locMapBufferRange(0x88EC, 0, GLsizeiptr(nBytes), 0x0002 | 0x0004 | 0x0020);
+
+			if (pDst == nullptr)
+			{
+				locBindBuffer(0x88EC, 0);
+				return false;
+			}
+
+			// The rectangle is packed tightly, which keeps the transfer as small as the dirty area
+			const olc::Pixel* pSrc = spr->pColData.data() + vPos.y * spr->width + vPos.x;
+			for (int32_t y = 0; y < vSize.y; y++)
+				std::memcpy(pDst + size_t(y) * nRowBytes, pSrc + size_t(y) * spr->width, nRowBytes);
+
+			if (pbo.pMapped == nullptr) locUnmapBuffer(0x88EC);
+
+			// With a buffer bound to GL_PIXEL_UNPACK_BUFFER the data pointer is an offset into it
+			if (bRespecify)
+				glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, vSize.x, vSize.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+			else
+				glTexSubImage2D(GL_TEXTURE_2D, 0, vPos.x, vPos.y, vSize.x, vSize.y, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+			pbo.fence = locFenceSync(0x9117, 0); // GL_SYNC_GPU_COMMANDS_COMPLETE
+			locBindBuffer(0x88EC, 0);
+			return true;
+		}
+
+		// GL 4.4 made buffer storage core, older contexts need to list the extension
+		bool HasBufferStorage()
+		{
+			if (locBufferStorage == nullptr) return false;
+
+			const char* sVersion = (const char*)glGetString(GL_VERSION);
+			int nMajor = 0, nMinor = 0;
+			if (sVersion != nullptr && std::sscanf(sVersion, "%d.%d", &nMajor, &nMinor) == 2 && (nMajor > 4 || (nMajor == 4 && nMinor >= 4)))
+				return true;
+
+			// Core profiles only list extensions one at a time, GL_NUM_EXTENSIONS
+			GLint nExtensions = 0;
+			glGetIntegerv(0x821D, &nExtensions);
+			if (locGetStringi != nullptr && glGetError() == GL_NO_ERROR)
+			{
+				for (GLint i = 0; i < nExtensions; i++)
+				{
+					const char* sName = (const char*)locGetStringi(GL_EXTENSIONS, GLuint(i));
+					if (sName != nullptr && std::strcmp(sName, "GL_ARB_buffer_storage") == 0) return true;
+				}
+				return false;
+			}
+
+			const char* sExtensions = (const char*)glGetString(GL_EXTENSIONS);
+			bool bFound = sExtensions != nullptr && std::strstr(sExtensions, "GL_ARB_buffer_storage") != nullptr;
+			while (glGetError() != GL_NO_ERROR) {}
+			return bFound;
+		}
+
+		bool CreatePixelBuffer(locPixelBuffer& pbo, size_t nBytes)
+		{
+			ReleasePixelBuffer(pbo);
+
+			// Errors left over from elsewhere must not count against the buffer
+			while (glGetError() != GL_NO_ERROR) {}
+
+			locGenBuffers(1, &pbo.id);
+			locBindBuffer(0x88EC, pbo.id);
+
+			if (locBufferStorage != nullptr)
+			{
+				// GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT
+				locBufferStorage(0x88EC, GLsizeiptr(nBytes), nullptr, 0x0002 | 0x0040 | 0x0080);
+				if (glGetError() == GL_NO_ERROR)
+				{
+					pbo.pMapped = (uint8_t*)locMapBufferRange(0x88EC, 0, GLsizeiptr(nBytes), 0x0002 | 0x0040 | 0x0080);
+					if (glGetError() != GL_NO_ERROR) pbo.pMapped = nullptr;
+				}
+
+				// Storage created with glBufferStorage is immutable, a plain buffer needs a new name.
+				// Having failed once, it is not tried again for the other buffers
+				if (pbo.pMapped == nullptr)
+				{
+					locBufferStorage = nullptr;
+					locBindBuffer(0x88EC, 0);
+					locDeleteBuffers(1, &pbo.id);
+					locGenBuffers(1, &pbo.id);
+					locBindBuffer(0x88EC, pbo.id);
+				}
+			}
+
+			bool bCreated = true;
+			if (pbo.pMapped == nullptr)
+			{
+				locBufferData(0x88EC, GLsizeiptr(nBytes), nullptr, 0x88E0); // GL_STREAM_DRAW
+				bCreated = glGetError() == GL_NO_ERROR;
+			}
+
+			pbo.nBytes = nBytes;
+			locBindBuffer(0x88EC, 0);
+			return bCreated;
+		}
+
+		void ReleasePixelBuffer(locPixelBuffer& pbo)
+		{
+			if (pbo.fence != nullptr) locDeleteSync(pbo.fence);
+			if (pbo.id != 0)
+			{
+				if (pbo.pMapped != nullptr)
+				{
+					locBindBuffer(0x88EC, pbo.id);
+					locUnmapBuffer(0x88EC);
+					locBindBuffer(0x88EC, 0);
+				}
+				locDeleteBuffers(1, &pbo.id);
+			}
+			pbo = locPixelBuffer();
+		}
+
+	public:
+#endif
+
+		void ReadTexture(uint32_t id, olc::Sprite* spr) override
+		{
+			glReadPixels(0, 0, spr->width, spr->height, GL_RGBA, GL_UNSIGNED_BYTE, spr->pColData.data());
+		}
+
+		void ApplyTexture(uint32_t id) override
+		{
+			glBindTexture(GL_TEXTURE_2D, id);
+		}
+
+		void ClearBuffer(olc::Pixel p, bool bDepth) override
+		{
+			glClearColor(float(p.r) / 255.0f, float(p.g) / 255.0f, float(p.b) / 255.0f, float(p.a) / 255.0f);
+			glClear(GL_COLOR_BUFFER_BIT);
+			if (bDepth) glClear(GL_DEPTH_BUFFER_BIT);
+		}
+
+		void UpdateViewport(const olc::vi2d& pos, const olc::vi2d& size) override
+		{
+			glViewport(pos.x, pos.y, size.x, size.y);
+		}
+	};
+}
+#endif
+// O------------------------------------------------------------------------------O
+// | END RENDERER: OpenGL 3.3 (3.0 es) (sh-sh-sh-shaders....)                     |
+// O------------------------------------------------------------------------------O
+#pragma endregion
+
+// O------------------------------------------------------------------------------O
+// | olcPixelGameEngine Image loaders                                             |
+// O------------------------------------------------------------------------------O
 
 #pragma region image_gdi
 // O------------------------------------------------------------------------------O
@@ -5151,8 +5930,18 @@ namespace olc
 			olc_WindowRoot = DefaultRootWindow(olc_Display);
 
 			// Based on the display capabilities, configure the appearance of the window
+#if defined(OLC_GFX_SOFTWARE)
+			// Nothing is drawn with GL, any 24 bit true colour visual can show the frame
+			XVisualInfo olc_VisualTemplate = {};
+			olc_VisualTemplate.screen = DefaultScreen(olc_Display);
+			olc_VisualTemplate.depth = 24;
+			olc_VisualTemplate.c_class = TrueColor;
+			int nVisuals = 0;
+			olc_VisualInfo = XGetVisualInfo(olc_Display, VisualScreenMask | VisualDepthMask | VisualClassMask, &olc_VisualTemplate, &nVisuals);
+#else
 			GLint olc_GLAttribs[] = { GLX_RGBA, GLX_DEPTH_SIZE, 24, GLX_DOUBLEBUFFER, None };
 			olc_VisualInfo = glXChooseVisual(olc_Display, 0, olc_GLAttribs);
+#endif
 			olc_ColourMap = XCreateColormap(olc_Display, olc_WindowRoot, olc_VisualInfo->visual, AllocNone);
 			olc_SetWindowAttribs.colormap = olc_ColourMap;
 
@@ -6094,6 +6883,900 @@ extern "C"
 
 #endif // Headless
 
+#pragma region renderer_software
+// O------------------------------------------------------------------------------O
+// | START RENDERER: Software, layers and decals composited on the CPU            |
+// O------------------------------------------------------------------------------O
+// Chosen with OLC_GFX_SOFTWARE, or for headless runs by handing a frame sprite to
+// olc_ConfigureHeadless(). The frame is drawn by row tiles spread over a pool of threads.
+// On X11 it is shown through an MIT-SHM image (link with -lXext), on Windows through GDI.
+namespace olc
+{
+	// Rows per tile, the unit of work handed to the compositing threads
+	constexpr int32_t OLC_SOFTWARE_TILE_ROWS = 16;
+
+	class Renderer_Software : public olc::Renderer
+	{
+	public:
+		// Composites into pFrame when given, which is then sized to the window. nThreads
+		// includes the engine thread, 0 picks one per hardware thread
+		explicit Renderer_Software(olc::Sprite* pFrame = nullptr, uint32_t nThreads = 0)
+			: pTarget(pFrame != nullptr ? pFrame : &sprFrame), nThreadCount(nThreads)
+		{
+			// Id 0 stands for "no texture", which samples as white
+			vTextures.emplace_back();
+		}
+
+		~Renderer_Software() override
+		{ StopWorkers(); }
+
+	private:
+		struct locTexture
+		{
+			int32_t nWidth = 0;
+			int32_t nHeight = 0;
+			std::vector<olc::Pixel> vData;
+			bool bFiltered = false;
+			bool bClamp = true;
+		};
+
+		// Positions are in frame pixels. uv and w are the decal's, already multiplied for
+		// warping, so the texture coordinate at a pixel is (sum of uv) / (sum of w)
+		struct locVertex
+		{
+			float x, y;
+			float u, v, w;
+			olc::Pixel col;
+		};
+
+		enum class locCommandType { CLEAR, QUAD, TRIANGLES, LINES };
+
+		struct locCommand
+		{
+			locCommandType type;
+			olc::DecalMode mode;
+			uint32_t nTexture;
+			olc::Pixel col;
+			olc::vi2d vViewPos;
+			olc::vi2d vViewSize;
+			olc::vf2d vOffset;
+			olc::vf2d vScale;
+			size_t nFirst;
+			size_t nCount;
+			bool bIdentity;
+		};
+
+		olc::Sprite sprFrame;
+		olc::Sprite* pTarget = nullptr;
+		std::vector<locTexture> vTextures;
+		std::vector<uint32_t> vFreeTextures;
+		uint32_t nActiveTexture = 0;
+
+		// Everything drawn in a frame is recorded and only composited in DisplayFrame()
+		std::vector<locCommand> vCommands;
+		std::vector<locVertex> vVertices;
+		std::vector<int32_t> vColumns;
+		olc::DecalMode nDecalMode = olc::DecalMode::NORMAL;
+		olc::vi2d vViewPos = { 0, 0 };
+		olc::vi2d vViewSize = { 0, 0 };
+
+		// The composited rows are converted into this, for platforms that show the frame
+		uint32_t* pPresent = nullptr;
+		int32_t nPresentPitch = 0;
+		bool bPresentBGR = true;
+
+		uint32_t nThreadCount = 0;
+		std::vector<std::thread> vWorkers;
+		std::vector<std::vector<olc::Pixel>> vScratch;
+		std::mutex muxWork;
+		std::condition_variable cvWork;
+		std::condition_variable cvDone;
+		uint64_t nGeneration = 0;
+		size_t nBusy = 0;
+		bool bQuit = false;
+		std::atomic<int32_t> nNextTile{ 0 };
+		int32_t nTiles = 0;
+
+#if !defined(OLC_PGE_HEADLESS) && defined(OLC_GFX_SOFTWARE) && defined(OLC_PLATFORM_X11)
+		X11::Display* olc_Display = nullptr;
+		X11::Window* olc_Window = nullptr;
+		X11::XVisualInfo* olc_VisualInfo = nullptr;
+		X11::GC olc_GC = 0;
+		X11::XImage* olc_Image = nullptr;
+		X11::XShmSegmentInfo olc_ShmInfo = {};
+		bool bShm = false;
+#endif
+
+#if !defined(OLC_PGE_HEADLESS) && defined(OLC_GFX_SOFTWARE) && defined(OLC_PLATFORM_WINAPI)
+		HWND olc_hWnd = nullptr;
+		std::vector<uint32_t> vBGRA;
+#endif
+
+	public:
+		void PrepareDevice() override
+		{}
+
+		olc::rcode CreateDevice(std::vector<void*> params, bool bFullScreen, bool bVSYNC) override
+		{
+			// Frames are presented by blitting, there is no mode or swap interval to set
+			UNUSED(params);
+			UNUSED(bFullScreen);
+			UNUSED(bVSYNC);
+#if !defined(OLC_PGE_HEADLESS) && defined(OLC_GFX_SOFTWARE) && defined(OLC_PLATFORM_X11)
+			olc_Display = (X11::Display*)(params[0]);
+			olc_Window = (X11::Window*)(params[1]);
+			olc_VisualInfo = (X11::XVisualInfo*)(params[2]);
+			olc_GC = X11::XCreateGC(olc_Display, *olc_Window, 0, nullptr);
+#endif
+
+#if !defined(OLC_PGE_HEADLESS) && defined(OLC_GFX_SOFTWARE) && defined(OLC_PLATFORM_WINAPI)
+			olc_hWnd = (HWND)(params[0]);
+#endif
+			StartWorkers();
+			return olc::rcode::OK;
+		}
+
+		olc::rcode DestroyDevice() override
+		{
+			StopWorkers();
+#if !defined(OLC_PGE_HEADLESS) && defined(OLC_GFX_SOFTWARE) && defined(OLC_PLATFORM_X11)
+			DestroyImage();
+			if (olc_GC != 0) X11::XFreeGC(olc_Display, olc_GC);
+			olc_GC = 0;
+#endif
+			return olc::rcode::OK;
+		}
+
+		void DisplayFrame() override
+		{
+			ResizeFrame(ptrPGE->GetWindowSize());
+			Composite();
+
+#if !defined(OLC_PGE_HEADLESS) && defined(OLC_GFX_SOFTWARE) && defined(OLC_PLATFORM_X11)
+			if (olc_Image != nullptr)
+			{
+				if (bShm)
+					X11::XShmPutImage(olc_Display, *olc_Window, olc_GC, olc_Image, 0, 0, 0, 0, pTarget->width, pTarget->height, False);
+				else
+					X11::XPutImage(olc_Display, *olc_Window, olc_GC, olc_Image, 0, 0, 0, 0, pTarget->width, pTarget->height);
+
+				// The server reads the shared image, it must be done before the next frame is written
+				X11::XSync(olc_Display, False);
+			}
+#endif
+
+#if !defined(OLC_PGE_HEADLESS) && defined(OLC_GFX_SOFTWARE) && defined(OLC_PLATFORM_WINAPI)
+			BITMAPINFO bmi = {};
+			bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+			bmi.bmiHeader.biWidth = pTarget->width;
+			bmi.bmiHeader.biHeight = -pTarget->height; // Top down
+			bmi.bmiHeader.biPlanes = 1;
+			bmi.bmiHeader.biBitCount = 32;
+			bmi.bmiHeader.biCompression = BI_RGB;
+			HDC hDC = GetDC(olc_hWnd);
+			SetDIBitsToDevice(hDC, 0, 0, pTarget->width, pTarget->height, 0, 0, 0, pTarget->height, vBGRA.data(), &bmi, DIB_RGB_COLORS);
+			ReleaseDC(olc_hWnd, hDC);
+#endif
+
+			vCommands.clear();
+			vVertices.clear();
+			vColumns.clear();
+		}
+
+		void PrepareDrawing() override
+		{ nDecalMode = olc::DecalMode::NORMAL; }
+
+		void SetDecalMode(const olc::DecalMode& mode) override
+		{ nDecalMode = mode; }
+
+		void DrawLayerQuad(const olc::vf2d& offset, const olc::vf2d& scale, const olc::Pixel tint) override
+		{
+			locCommand cmd = NewCommand(locCommandType::QUAD, nDecalMode, nActiveTexture);
+			cmd.col = tint;
+			cmd.vOffset = offset;
+			cmd.vScale = scale;
+
+			// The texel column of every viewport column is the same on every row, so it is
+			// worked out once here. Layers at scale 1 usually map column to column
+			const locTexture& tex = vTextures[cmd.nTexture];
+			cmd.nFirst = vColumns.size();
+			cmd.nCount = size_t(std::max(vViewSize.x, 0));
+			cmd.bIdentity = tex.nWidth == vViewSize.x;
+			for (int32_t x = 0; x < vViewSize.x; x++)
+			{
+				float u = (float(x) + 0.5f) / float(vViewSize.x) * scale.x + offset.x;
+				int32_t tx = Wrap(int32_t(std::floor(u * float(tex.nWidth))), tex.nWidth, tex.bClamp);
+				vColumns.push_back(tx);
+				cmd.bIdentity &= tx == x;
+			}
+
+			vCommands.push_back(cmd);
+		}
+
+		void DrawDecal(const olc::DecalInstance& decal) override
+		{
+			const bool bWire = decal.mode == olc::DecalMode::WIREFRAME;
+			locCommand cmd = NewCommand(bWire ? locCommandType::LINES : locCommandType::TRIANGLES, decal.mode, decal.decal == nullptr ? 0 : decal.decal->id);
+			cmd.nFirst = vVertices.size();
+
+			auto vertex = [&](uint32_t i)
+			{
+				// From normalised device coordinates to frame pixels, y pointing down
+				vVertices.push_back({
+					float(vViewPos.x) + (decal.pos[i].x + 1.0f) * 0.5f * float(vViewSize.x),
+					float(vViewPos.y) + (1.0f - decal.pos[i].y) * 0.5f * float(vViewSize.y),
+					decal.uv[i].x, decal.uv[i].y, decal.w[i], decal.tint[i] });
+			};
+
+			// Lines are stored as pairs and triangles as lists, like the batched GL renderer
+			if (bWire)
+				for (uint32_t i = 0; i < decal.points; i++) { vertex(i); vertex((i + 1) % decal.points); }
+			else if (decal.structure == olc::DecalStructure::LIST)
+				for (uint32_t i = 0; i + 2 < decal.points; i += 3) { vertex(i); vertex(i + 1); vertex(i + 2); }
+			else if (decal.structure == olc::DecalStructure::STRIP)
+				for (uint32_t i = 0; i + 2 < decal.points; i++) { vertex(i); vertex(i + 1); vertex(i + 2); }
+			else
+				for (uint32_t i = 1; i + 1 < decal.points; i++) { vertex(0); vertex(i); vertex(i + 1); }
+
+			cmd.nCount = vVertices.size() - cmd.nFirst;
+			if (cmd.nCount > 0) vCommands.push_back(cmd);
+		}
+
+		uint32_t CreateTexture(const uint32_t width, const uint32_t height, const bool filtered, const bool clamp) override
+		{
+			uint32_t id = 0;
+			if (!vFreeTextures.empty())
+			{
+				id = vFreeTextures.back();
+				vFreeTextures.pop_back();
+			}
+			else
+			{
+				id = uint32_t(vTextures.size());
+				vTextures.emplace_back();
+			}
+
+			locTexture& tex = vTextures[id];
+			tex.nWidth = int32_t(width);
+			tex.nHeight = int32_t(height);
+			tex.vData.assign(size_t(width) * size_t(height), olc::BLANK);
+			tex.bFiltered = filtered;
+			tex.bClamp = clamp;
+			return id;
+		}
+
+		void UpdateTexture(uint32_t id, olc::Sprite* spr) override
+		{
+			if (id == 0 || id >= vTextures.size() || !spr->IsDirty()) return;
+
+			locTexture& tex = vTextures[id];
+			if (tex.nWidth != spr->width || tex.nHeight != spr->height)
+			{
+				tex.nWidth = spr->width;
+				tex.nHeight = spr->height;
+				tex.vData = spr->pColData;
+				return;
+			}
+
+			// Only the rows and columns written since the last update are copied
+			const olc::vi2d vPos = spr->vDirtyMin, vSize = spr->vDirtyMax - spr->vDirtyMin;
+			for (int32_t y = vPos.y; y < vPos.y + vSize.y; y++)
+				std::memcpy(tex.vData.data() + size_t(y) * tex.nWidth + vPos.x, spr->pColData.data() + size_t(y) * spr->width + vPos.x, size_t(vSize.x) * sizeof(olc::Pixel));
+		}
+
+		void ReadTexture(uint32_t id, olc::Sprite* spr) override
+		{
+			if (id == 0 || id >= vTextures.size()) return;
+			const locTexture& tex = vTextures[id];
+			if (tex.nWidth == spr->width && tex.nHeight == spr->height)
+				spr->pColData = tex.vData;
+		}
+
+		uint32_t DeleteTexture(const uint32_t id) override
+		{
+			if (id != 0 && id < vTextures.size())
+			{
+				vTextures[id] = locTexture();
+				vFreeTextures.push_back(id);
+			}
+			return id;
+		}
+
+		void ApplyTexture(uint32_t id) override
+		{ nActiveTexture = id < vTextures.size() ? id : 0; }
+
+		void UpdateViewport(const olc::vi2d& pos, const olc::vi2d& size) override
+		{
+			vViewPos = pos;
+			vViewSize = size;
+		}
+
+		void ClearBuffer(olc::Pixel p, bool bDepth) override
+		{
+			UNUSED(bDepth);
+			locCommand cmd = NewCommand(locCommandType::CLEAR, olc::DecalMode::NORMAL, 0);
+			cmd.col = p;
+			vCommands.push_back(cmd);
+		}
+
+	private:
+		locCommand NewCommand(locCommandType type, olc::DecalMode mode, uint32_t nTexture) const
+		{
+			locCommand cmd = {};
+			cmd.type = type;
+			cmd.mode = mode;
+			cmd.nTexture = nTexture < vTextures.size() ? nTexture : 0;
+			cmd.col = olc::WHITE;
+			cmd.vViewPos = vViewPos;
+			cmd.vViewSize = vViewSize;
+			return cmd;
+		}
+
+		static int32_t Wrap(int32_t i, int32_t n, bool bClamp)
+		{
+			if (n <= 0) return 0;
+			if (bClamp) return std::clamp(i, 0, n - 1);
+			i %= n;
+			return i < 0 ? i + n : i;
+		}
+
+		olc::Pixel Sample(const locTexture& tex, float u, float v) const
+		{
+			if (tex.vData.empty()) return olc::WHITE;
+
+			if (!tex.bFiltered)
+			{
+				int32_t x = Wrap(int32_t(std::floor(u * float(tex.nWidth))), tex.nWidth, tex.bClamp);
+				int32_t y = Wrap(int32_t(std::floor(v * float(tex.nHeight))), tex.nHeight, tex.bClamp);
+				return tex.vData[size_t(y) * tex.nWidth + x];
+			}
+
+			// Texel centres sit at half coordinates, as with GL_LINEAR
+			float fx = u * float(tex.nWidth) - 0.5f, fy = v * float(tex.nHeight) - 0.5f;
+			int32_t x0 = int32_t(std::floor(fx)), y0 = int32_t(std::floor(fy));
+			uint32_t ax = uint32_t((fx - float(x0)) * 256.0f), ay = uint32_t((fy - float(y0)) * 256.0f);
+			int32_t x1 = Wrap(x0 + 1, tex.nWidth, tex.bClamp), y1 = Wrap(y0 + 1, tex.nHeight, tex.bClamp);
+			x0 = Wrap(x0, tex.nWidth, tex.bClamp); y0 = Wrap(y0, tex.nHeight, tex.bClamp);
+
+			const olc::Pixel p00 = tex.vData[size_t(y0) * tex.nWidth + x0], p10 = tex.vData[size_t(y0) * tex.nWidth + x1];
+			const olc::Pixel p01 = tex.vData[size_t(y1) * tex.nWidth + x0], p11 = tex.vData[size_t(y1) * tex.nWidth + x1];
+			auto lerp = [&](uint8_t c00, uint8_t c10, uint8_t c01, uint8_t c11)
+			{
+				uint32_t top = c00 * (256 - ax) + c10 * ax, bottom = c01 * (256 - ax) + c11 * ax;
+				return uint8_t((top * (256 - ay) + bottom * ay + 32768) >> 16);
+			};
+			return olc::Pixel(lerp(p00.r, p10.r, p01.r, p11.r), lerp(p00.g, p10.g, p01.g, p11.g), lerp(p00.b, p10.b, p01.b, p11.b), lerp(p00.a, p10.a, p01.a, p11.a));
+		}
+
+		static olc::Pixel Modulate(const olc::Pixel t, const olc::Pixel c)
+		{
+			if (c == olc::WHITE) return t;
+			return olc::Pixel(uint8_t(blend::Div255(t.r * c.r)), uint8_t(blend::Div255(t.g * c.g)), uint8_t(blend::Div255(t.b * c.b)), uint8_t(blend::Div255(t.a * c.a)));
+		}
+
+		// Blends a span of fragments onto the frame with the factors the GL renderers use
+		static void BlendSpan(olc::Pixel* pDst, const olc::Pixel* pSrc, int32_t nCount, olc::DecalMode mode)
+		{
+			using blend::Div255;
+			switch (mode)
+			{
+			case olc::DecalMode::ADDITIVE: // src * a + dst
+			{
+				int32_t i = 0;
+#if defined(OLC_BLEND_SSE2) || defined(OLC_BLEND_AVX2)
+				const __m128i zero = _mm_setzero_si128();
+				const __m128i half = _mm_set1_epi16(128);
+				auto Lanes = [&](__m128i s)
+				{
+					__m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xFF), 0xFF);
+					return blend::Div255(_mm_add_epi16(_mm_mullo_epi16(s, a), half));
+				};
+				for (; i + 4 <= nCount; i += 4)
+				{
+					__m128i s = _mm_loadu_si128((const __m128i*)(pSrc + i));
+					__m128i d = _mm_loadu_si128((const __m128i*)(pDst + i));
+					__m128i sa = _mm_packus_epi16(Lanes(_mm_unpacklo_epi8(s, zero)), Lanes(_mm_unpackhi_epi8(s, zero)));
+					_mm_storeu_si128((__m128i*)(pDst + i), _mm_adds_epu8(d, sa));
+				}
+#endif
+				for (; i < nCount; i++)
+				{
+					const olc::Pixel s = pSrc[i]; olc::Pixel& d = pDst[i];
+					d = olc::Pixel(uint8_t(std::min(255u, d.r + Div255(s.r * s.a))), uint8_t(std::min(255u, d.g + Div255(s.g * s.a))),
+						uint8_t(std::min(255u, d.b + Div255(s.b * s.a))), uint8_t(std::min(255u, d.a + Div255(s.a * s.a))));
+				}
+				break;
+			}
+
+			case olc::DecalMode::MULTIPLICATIVE: // src * dst + dst * (1 - a)
+				for (int32_t i = 0; i < nCount; i++)
+				{
+					const olc::Pixel s = pSrc[i]; olc::Pixel& d = pDst[i]; const uint32_t c = 255 - s.a;
+					d = olc::Pixel(uint8_t(std::min(255u, Div255(s.r * d.r + d.r * c))), uint8_t(std::min(255u, Div255(s.g * d.g + d.g * c))),
+						uint8_t(std::min(255u, Div255(s.b * d.b + d.b * c))), uint8_t(std::min(255u, Div255(s.a * d.a + d.a * c))));
+				}
+				break;
+
+			case olc::DecalMode::STENCIL: // dst * a
+				for (int32_t i = 0; i < nCount; i++)
+				{
+					const uint32_t a = pSrc[i].a; olc::Pixel& d = pDst[i];
+					d = olc::Pixel(uint8_t(Div255(d.r * a)), uint8_t(Div255(d.g * a)), uint8_t(Div255(d.b * a)), uint8_t(Div255(d.a * a)));
+				}
+				break;
+
+			case olc::DecalMode::ILLUMINATE: // src * (1 - a) + dst * a
+				for (int32_t i = 0; i < nCount; i++)
+				{
+					const olc::Pixel s = pSrc[i]; olc::Pixel& d = pDst[i];
+					d = blend::Mix(d, s, s.a);
+				}
+				break;
+
+			default: // NORMAL, WIREFRAME and MODEL3D: src * a + dst * (1 - a)
+				blend::SourceSpan(pDst, pSrc, nCount, 255);
+				break;
+			}
+		}
+
+		void ResizeFrame(const olc::vi2d& vSize)
+		{
+			if (vSize.x == pTarget->width && vSize.y == pTarget->height && !pTarget->pColData.empty()) return;
+
+			pTarget->width = std::max(vSize.x, 1);
+			pTarget->height = std::max(vSize.y, 1);
+			pTarget->pColData.assign(size_t(pTarget->width) * size_t(pTarget->height), olc::BLACK);
+
+#if !defined(OLC_PGE_HEADLESS) && defined(OLC_GFX_SOFTWARE) && defined(OLC_PLATFORM_X11)
+			CreateImage();
+#endif
+
+#if !defined(OLC_PGE_HEADLESS) && defined(OLC_GFX_SOFTWARE) && defined(OLC_PLATFORM_WINAPI)
+			vBGRA.assign(pTarget->pColData.size(), 0);
+			pPresent = vBGRA.data();
+			nPresentPitch = pTarget->width;
+			bPresentBGR = true;
+#endif
+		}
+
+#if !defined(OLC_PGE_HEADLESS) && defined(OLC_GFX_SOFTWARE) && defined(OLC_PLATFORM_X11)
+		void CreateImage()
+		{
+			using namespace X11;
+			DestroyImage();
+			const int w = pTarget->width, h = pTarget->height;
+
+			// Shared memory saves copying every frame through the socket, but only works locally
+			if (XShmQueryExtension(olc_Display))
+			{
+				olc_Image = XShmCreateImage(olc_Display, olc_VisualInfo->visual, olc_VisualInfo->depth, ZPixmap, nullptr, &olc_ShmInfo, w, h);
+				if (olc_Image != nullptr)
+				{
+					olc_ShmInfo.shmid = shmget(IPC_PRIVATE, size_t(olc_Image->bytes_per_line) * size_t(olc_Image->height), IPC_CREAT | 0600);
+					olc_ShmInfo.shmaddr = olc_Image->data = (olc_ShmInfo.shmid < 0) ? (char*)-1 : (char*)shmat(olc_ShmInfo.shmid, nullptr, 0);
+					olc_ShmInfo.readOnly = False;
+					bShm = olc_ShmInfo.shmaddr != (char*)-1 && XShmAttach(olc_Display, &olc_ShmInfo);
+					XSync(olc_Display, False);
+
+					// Marked for removal now, it goes away once both sides have detached
+					if (olc_ShmInfo.shmid >= 0) shmctl(olc_ShmInfo.shmid, IPC_RMID, nullptr);
+					if (!bShm)
+					{
+						if (olc_ShmInfo.shmaddr != (char*)-1) shmdt(olc_ShmInfo.shmaddr);
+						olc_Image->data = nullptr;
+						XDestroyImage(olc_Image);
+						olc_Image = nullptr;
+					}
+				}
+			}
+
+			if (olc_Image == nullptr)
+			{
+				char* pData = (char*)malloc(size_t(w) * size_t(h) * 4);
+				olc_Image = XCreateImage(olc_Display, olc_VisualInfo->visual, olc_VisualInfo->depth, ZPixmap, 0, pData, w, h, 32, 0);
+			}
+
+			pPresent = (uint32_t*)olc_Image->data;
+			nPresentPitch = olc_Image->bytes_per_line / 4;
+			bPresentBGR = olc_Image->red_mask == 0xFF0000;
+		}
+
+		void DestroyImage()
+		{
+			if (olc_Image == nullptr) return;
+			if (bShm)
+			{
+				X11::XShmDetach(olc_Display, &olc_ShmInfo);
+				X11::XSync(olc_Display, False);
+				shmdt(olc_ShmInfo.shmaddr);
+				olc_Image->data = nullptr;
+			}
+			XDestroyImage(olc_Image);
+			olc_Image = nullptr;
+			pPresent = nullptr;
+			bShm = false;
+		}
+#endif
+
+		void StartWorkers()
+		{
+			if (!vWorkers.empty()) return;
+			uint32_t nThreads = nThreadCount != 0 ? nThreadCount : std::max(1u, std::thread::hardware_concurrency());
+			vScratch.resize(nThreads);
+			bQuit = false;
+			for (uint32_t i = 1; i < nThreads; i++)
+				vWorkers.emplace_back(&Renderer_Software::WorkerLoop, this, size_t(i));
+		}
+
+		void StopWorkers()
+		{
+			{
+				std::lock_guard<std::mutex> lock(muxWork);
+				bQuit = true;
+			}
+			cvWork.notify_all();
+			for (auto& worker : vWorkers) worker.join();
+			vWorkers.clear();
+		}
+
+		void WorkerLoop(size_t nWorker)
+		{
+			uint64_t nSeen = 0;
+			for (;;)
+			{
+				{
+					std::unique_lock<std::mutex> lock(muxWork);
+					cvWork.wait(lock, [&] { return bQuit || nGeneration != nSeen; });
+					if (bQuit) return;
+					nSeen = nGeneration;
+				}
+
+				RunTiles(nWorker);
+
+				std::lock_guard<std::mutex> lock(muxWork);
+				if (--nBusy == 0) cvDone.notify_one();
+			}
+		}
+
+		// Every tile replays all commands of the frame in order, clipped to its rows, so tiles
+		// never touch the same pixels and need no synchronisation among each other
+		void Composite()
+		{
+			if (vScratch.empty()) vScratch.resize(1);
+			nTiles = (pTarget->height + OLC_SOFTWARE_TILE_ROWS - 1) / OLC_SOFTWARE_TILE_ROWS;
+			nNextTile = 0;
+
+			{
+				std::lock_guard<std::mutex> lock(muxWork);
+				nBusy = vWorkers.size();
+				nGeneration++;
+			}
+			cvWork.notify_all();
+
+			RunTiles(0);
+
+			std::unique_lock<std::mutex> lock(muxWork);
+			cvDone.wait(lock, [&] { return nBusy == 0; });
+		}
+
+		void RunTiles(size_t nWorker)
+		{
+			for (int32_t nTile = nNextTile++; nTile < nTiles; nTile = nNextTile++)
+				RenderTile(nTile * OLC_SOFTWARE_TILE_ROWS, std::min(pTarget->height, (nTile + 1) * OLC_SOFTWARE_TILE_ROWS), vScratch[nWorker]);
+		}
+
+		void RenderTile(int32_t y0, int32_t y1, std::vector<olc::Pixel>& vRow)
+		{
+			if (vRow.size() < size_t(pTarget->width)) vRow.resize(pTarget->width);
+			olc::Pixel* pFrame = pTarget->pColData.data();
+			const int32_t nWidth = pTarget->width;
+
+			for (const auto& cmd : vCommands)
+			{
+				// Like the GL renderers, nothing is drawn outside the viewport
+				const int32_t cx0 = std::max(0, cmd.vViewPos.x), cx1 = std::min(nWidth, cmd.vViewPos.x + cmd.vViewSize.x);
+				const int32_t cy0 = std::max(y0, cmd.vViewPos.y), cy1 = std::min(y1, cmd.vViewPos.y + cmd.vViewSize.y);
+
+				switch (cmd.type)
+				{
+				case locCommandType::CLEAR:
+					span::Fill(pFrame + size_t(y0) * nWidth, size_t(y1 - y0) * nWidth, cmd.col, false);
+					break;
+
+				case locCommandType::QUAD:
+					if (cx0 < cx1) DrawQuadRows(cmd, cx0, cx1, cy0, cy1, vRow);
+					break;
+
+				case locCommandType::TRIANGLES:
+					if (cx0 < cx1)
+						for (size_t i = 0; i + 2 < cmd.nCount; i += 3)
+							DrawTriangle(cmd, vVertices[cmd.nFirst + i], vVertices[cmd.nFirst + i + 1], vVertices[cmd.nFirst + i + 2], cx0, cx1, cy0, cy1, vRow);
+					break;
+
+				case locCommandType::LINES:
+					if (cx0 < cx1)
+						for (size_t i = 0; i + 1 < cmd.nCount; i += 2)
+							DrawLine(cmd, vVertices[cmd.nFirst + i], vVertices[cmd.nFirst + i + 1], cx0, cx1, cy0, cy1);
+					break;
+				}
+			}
+
+			// The window wants 0x00RRGGBB (or the reverse), the frame holds RGBA bytes
+			if (pPresent != nullptr)
+			{
+				for (int32_t y = y0; y < y1; y++)
+				{
+					const olc::Pixel* pSrc = pFrame + size_t(y) * nWidth;
+					uint32_t* pDst = pPresent + size_t(y) * nPresentPitch;
+					if (bPresentBGR)
+						for (int32_t x = 0; x < nWidth; x++) { uint32_t n = pSrc[x].n; pDst[x] = ((n & 0xFF) << 16) | (n & 0xFF00) | ((n >> 16) & 0xFF); }
+					else
+						for (int32_t x = 0; x < nWidth; x++) pDst[x] = pSrc[x].n & 0xFFFFFF;
+				}
+			}
+		}
+
+		void DrawQuadRows(const locCommand& cmd, int32_t x0, int32_t x1, int32_t y0, int32_t y1, std::vector<olc::Pixel>& vRow)
+		{
+			const locTexture& tex = vTextures[cmd.nTexture];
+			const int32_t* pColumns = vColumns.data() + cmd.nFirst;
+			const int32_t nCount = x1 - x0;
+
+			for (int32_t y = y0; y < y1; y++)
+			{
+				olc::Pixel* pDst = pTarget->pColData.data() + size_t(y) * pTarget->width + x0;
+				const float v = (float(y - cmd.vViewPos.y) + 0.5f) / float(cmd.vViewSize.y) * cmd.vScale.y + cmd.vOffset.y;
+				const olc::Pixel* pSrc = nullptr;
+
+				if (tex.vData.empty())
+				{
+					std::fill_n(vRow.data(), nCount, olc::WHITE);
+					pSrc = vRow.data();
+				}
+				else if (tex.bFiltered)
+				{
+					for (int32_t x = x0; x < x1; x++)
+						vRow[x - x0] = Sample(tex, (float(x - cmd.vViewPos.x) + 0.5f) / float(cmd.vViewSize.x) * cmd.vScale.x + cmd.vOffset.x, v);
+					pSrc = vRow.data();
+				}
+				else
+				{
+					const int32_t ty = Wrap(int32_t(std::floor(v * float(tex.nHeight))), tex.nHeight, tex.bClamp);
+					const olc::Pixel* pTexRow = tex.vData.data() + size_t(ty) * tex.nWidth;
+					if (cmd.bIdentity)
+						pSrc = pTexRow + (x0 - cmd.vViewPos.x);
+					else
+					{
+						for (int32_t x = x0; x < x1; x++)
+							vRow[x - x0] = pTexRow[pColumns[x - cmd.vViewPos.x]];
+						pSrc = vRow.data();
+					}
+				}
+
+				if (cmd.col != olc::WHITE)
+				{
+					for (int32_t i = 0; i < nCount; i++) vRow[i] = Modulate(pSrc[i], cmd.col);
+					pSrc = vRow.data();
+				}
+
+				BlendSpan(pDst, pSrc, nCount, cmd.mode);
+			}
+		}
+
+		// Pixels whose centre lies inside are covered. On an edge, only edges that are top or
+		// left ones cover it, so triangles sharing an edge never both draw a pixel
+		void DrawTriangle(const locCommand& cmd, const locVertex& a, locVertex b, locVertex c, int32_t x0, int32_t x1, int32_t y0, int32_t y1, std::vector<olc::Pixel>& vRow)
+		{
+			float fArea = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+			if (fArea == 0.0f) return;
+			if (fArea < 0.0f) { std::swap(b, c); fArea = -fArea; }
+
+			const int32_t ry0 = std::max(y0, int32_t(std::ceil(std::min({ a.y, b.y, c.y }) - 0.5f)));
+			const int32_t ry1 = std::min(y1, int32_t(std::ceil(std::max({ a.y, b.y, c.y }) - 0.5f)));
+			if (ry0 >= ry1) return;
+
+			// Edge i lies opposite vertex i, E_i(x, y) = A x + B y + C is its weight times the area
+			const locVertex* v[3] = { &a, &b, &c };
+			float A[3], B[3], C[3]; bool bInclusive[3];
+			for (int i = 0; i < 3; i++)
+			{
+				const locVertex& p = *v[(i + 1) % 3];
+				const locVertex& q = *v[(i + 2) % 3];
+				A[i] = -(q.y - p.y); B[i] = q.x - p.x;
+				C[i] = -(A[i] * p.x + B[i] * p.y);
+				bInclusive[i] = (q.y - p.y) > 0.0f || ((q.y - p.y) == 0.0f && (q.x - p.x) < 0.0f);
+			}
+
+			const locTexture& tex = vTextures[cmd.nTexture];
+			const bool bFlat = a.col == b.col && b.col == c.col;
+			const float fInvArea = 1.0f / fArea;
+
+			for (int32_t y = ry0; y < ry1; y++)
+			{
+				const float yc = float(y) + 0.5f;
+				int32_t xl = x0, xr = x1;
+				float k[3];
+
+				for (int i = 0; i < 3 && xl < xr; i++)
+				{
+					k[i] = B[i] * yc + C[i];
+					if (A[i] > 0.0f)
+					{
+						const float t = -k[i] / A[i] - 0.5f;
+						xl = std::max(xl, bInclusive[i] ? int32_t(std::ceil(t)) : int32_t(std::floor(t)) + 1);
+					}
+					else if (A[i] < 0.0f)
+					{
+						const float t = -k[i] / A[i] - 0.5f;
+						xr = std::min(xr, bInclusive[i] ? int32_t(std::floor(t)) + 1 : int32_t(std::ceil(t)));
+					}
+					else if (!(k[i] > 0.0f || (k[i] == 0.0f && bInclusive[i])))
+						xr = xl;
+				}
+
+				if (xl >= xr) continue;
+
+				for (int32_t x = xl; x < xr; x++)
+				{
+					const float xc = float(x) + 0.5f;
+					const float l0 = (A[0] * xc + k[0]) * fInvArea, l1 = (A[1] * xc + k[1]) * fInvArea, l2 = (A[2] * xc + k[2]) * fInvArea;
+					const float fW = l0 * a.w + l1 * b.w + l2 * c.w;
+					const float fInvW = fW != 0.0f ? 1.0f / fW : 0.0f;
+					const olc::Pixel texel = Sample(tex, (l0 * a.u + l1 * b.u + l2 * c.u) * fInvW, (l0 * a.v + l1 * b.v + l2 * c.v) * fInvW);
+
+					olc::Pixel col = a.col;
+					if (!bFlat)
+					{
+						// Colours are interpolated with the same perspective as the texture
+						const float w0 = l0 * a.w * fInvW, w1 = l1 * b.w * fInvW, w2 = l2 * c.w * fInvW;
+						auto mix = [&](uint8_t c0, uint8_t c1, uint8_t c2) { return uint8_t(std::clamp(w0 * c0 + w1 * c1 + w2 * c2 + 0.5f, 0.0f, 255.0f)); };
+						col = olc::Pixel(mix(a.col.r, b.col.r, c.col.r), mix(a.col.g, b.col.g, c.col.g), mix(a.col.b, b.col.b, c.col.b), mix(a.col.a, b.col.a, c.col.a));
+					}
+
+					vRow[x - xl] = Modulate(texel, col);
+				}
+
+				BlendSpan(pTarget->pColData.data() + size_t(y) * pTarget->width + xl, vRow.data(), xr - xl, cmd.mode);
+			}
+		}
+
+		// Steps one pixel along the major axis and leaves out the last one, so that the edges
+		// of a loop do not draw their shared corners twice
+		void DrawLine(const locCommand& cmd, const locVertex& a, const locVertex& b, int32_t x0, int32_t x1, int32_t y0, int32_t y1)
+		{
+			const float dx = b.x - a.x, dy = b.y - a.y;
+			const int32_t nSteps = int32_t(std::ceil(std::max(std::abs(dx), std::abs(dy))));
+			const locTexture& tex = vTextures[cmd.nTexture];
+
+			for (int32_t i = 0; i < nSteps; i++)
+			{
+				const float t = float(i) / float(nSteps);
+				const int32_t x = int32_t(std::floor(a.x + dx * t)), y = int32_t(std::floor(a.y + dy * t));
+				if (x < x0 || x >= x1 || y < y0 || y >= y1) continue;
+
+				const float fW = a.w + (b.w - a.w) * t;
+				const float fInvW = fW != 0.0f ? 1.0f / fW : 0.0f;
+				const olc::Pixel texel = Sample(tex, (a.u + (b.u - a.u) * t) * fInvW, (a.v + (b.v - a.v) * t) * fInvW);
+				const olc::Pixel col = (a.col == b.col) ? a.col : olc::PixelLerp(a.col, b.col, t);
+				const olc::Pixel frag = Modulate(texel, col);
+				BlendSpan(pTarget->pColData.data() + size_t(y) * pTarget->width + x, &frag, 1, cmd.mode);
+			}
+		}
+	};
+}
+// O------------------------------------------------------------------------------O
+// | END RENDERER: Software                                                       |
+// O------------------------------------------------------------------------------O
+#pragma endregion
+
+#pragma region headless
+// O------------------------------------------------------------------------------O
+// | START HEADLESS: No window, no GPU, frames only exist in sprite memory        |
+// O------------------------------------------------------------------------------O
+namespace olc
+{
+	class Renderer_Headless : public olc::Renderer
+	{
+	private:
+		uint32_t nNextTexture = 0;
+
+	public:
+		void PrepareDevice() override
+		{}
+
+		olc::rcode CreateDevice(std::vector<void*> params, bool bFullScreen, bool bVSYNC) override
+		{ UNUSED(params); UNUSED(bFullScreen); UNUSED(bVSYNC); return olc::rcode::OK; }
+
+		olc::rcode DestroyDevice() override
+		{ return olc::rcode::OK; }
+
+		void DisplayFrame() override
+		{}
+
+		void PrepareDrawing() override
+		{}
+
+		void SetDecalMode(const olc::DecalMode& mode) override
+		{ UNUSED(mode); }
+
+		void DrawLayerQuad(const olc::vf2d& offset, const olc::vf2d& scale, const olc::Pixel tint) override
+		{ UNUSED(offset); UNUSED(scale); UNUSED(tint); }
+
+		void DrawDecal(const olc::DecalInstance& decal) override
+		{ UNUSED(decal); }
+
+		uint32_t CreateTexture(const uint32_t width, const uint32_t height, const bool filtered, const bool clamp) override
+		{
+			UNUSED(width);
+			UNUSED(height);
+			UNUSED(filtered);
+			UNUSED(clamp);
+			// Ids only need to be unique, there is nothing behind them
+			return ++nNextTexture;
+		}
+
+		void UpdateTexture(uint32_t id, olc::Sprite* spr) override
+		{ UNUSED(id); UNUSED(spr); }
+
+		void ReadTexture(uint32_t id, olc::Sprite* spr) override
+		{ UNUSED(id); UNUSED(spr); }
+
+		uint32_t DeleteTexture(const uint32_t id) override
+		{ return id; }
+
+		void ApplyTexture(uint32_t id) override
+		{ UNUSED(id); }
+
+		void UpdateViewport(const olc::vi2d& pos, const olc::vi2d& size) override
+		{ UNUSED(pos); UNUSED(size); }
+
+		void ClearBuffer(olc::Pixel p, bool bDepth) override
+		{ UNUSED(p); UNUSED(bDepth); }
+	};
+
+	class Platform_Headless : public olc::Platform
+	{
+	public:
+		virtual olc::rcode ApplicationStartUp() override { return olc::rcode::OK; }
+		virtual olc::rcode ApplicationCleanUp() override { return olc::rcode::OK; }
+		virtual olc::rcode ThreadStartUp() override { return olc::rcode::OK; }
+		virtual olc::rcode ThreadCleanUp() override { return olc::rcode::OK; }
+
+		virtual olc::rcode CreateGraphics(bool bFullScreen, bool bEnableVSYNC, const olc::vi2d& vViewPos, const olc::vi2d& vViewSize) override
+		{ UNUSED(vViewPos); UNUSED(vViewSize); return renderer->CreateDevice({}, bFullScreen, bEnableVSYNC); }
+
+		virtual olc::rcode CreateWindowPane(const olc::vi2d& vWindowPos, olc::vi2d& vWindowSize, bool bFullScreen) override
+		{
+			UNUSED(vWindowPos);
+			UNUSED(vWindowSize);
+			UNUSED(bFullScreen);
+			// There is no window to gain focus, so input is always accepted
+			ptrPGE->olc_UpdateKeyFocus(true);
+			ptrPGE->olc_UpdateMouseFocus(true);
+			return olc::rcode::OK;
+		}
+
+		virtual olc::rcode SetWindowTitle(const std::string& s) override { UNUSED(s); return olc::rcode::OK; }
+		virtual olc::rcode StartSystemEventLoop() override { return olc::rcode::OK; }
+		virtual olc::rcode HandleSystemEvent() override { return olc::rcode::OK; }
+	};
+
+	void PixelGameEngine::olc_ConfigureHeadless(olc::Sprite* pFrame)
+	{
+		platform = std::make_unique<olc::Platform_Headless>();
+		if (pFrame != nullptr)
+			renderer = std::make_unique<olc::Renderer_Software>(pFrame);
+		else
+			renderer = std::make_unique<olc::Renderer_Headless>();
+		platform->ptrPGE = this;
+		renderer->ptrPGE = this;
+	}
+}
+// O------------------------------------------------------------------------------O
+// | END HEADLESS                                                                 |
+// O------------------------------------------------------------------------------O
+#pragma endregion
+
 // O------------------------------------------------------------------------------O
 // | olcPixelGameEngine Auto-Configuration                                        |
 // O------------------------------------------------------------------------------O
@@ -6154,6 +7837,10 @@ namespace olc
 		renderer = std::make_unique<olc::Renderer_OGL33>();
 #endif
 
+#if defined(OLC_GFX_SOFTWARE)
+		renderer = std::make_unique<olc::Renderer_Software>();
+#endif
+
 #if defined(OLC_GFX_OPENGLES2)
 		renderer = std::make_unique<olc::Renderer_OGLES2>();
 #endif
@@ -6175,8 +7862,7 @@ namespace olc
 		renderer->ptrPGE = this;
 #else
 		olc::Sprite::loader = nullptr;
-		platform = nullptr;
-		renderer = nullptr;
+		olc_ConfigureHeadless();
 #endif
 	}
 }
@@ -1,16 +1,31 @@
 #define OLC_PGE_APPLICATION
+// Needs to come before the engine so that its zones are recorded too
+#include "profiler.h"
 #include "olcPixelGameEngine.h"
+#include "edge_store.h"
+#include "occluder_optimizer.h"
+#include "visibility.h"
+#include "ray_visibility.h"
+#include "uniform_grid.h"
+#include "bvh.h"
+#include "thread_pool.h"
+#include "visibility_cache.h"
+#include "visibility_patch.h"
+#include "tile_rasterizer.h"
+#include "headless.h"
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
 #include <vector>
 #include <string>
 
 // TODO: determine what this project should become
-struct line
+struct light
 {
-  int x1;
-  int y1;
-  int x2;
-  int y2;
+  olc::vi2d position;
+  olc::Pixel colour;
 };
 
 enum DIRECTION
@@ -28,8 +43,61 @@ enum STATE
   CAST_LIGHT
 };
 
+enum VISIBILITY
+{
+  ANGULAR_SWEEP,
+  RAY_CASTING
+};
+
+enum TONE_MAP
+{
+  CLIP,
+  SOFT
+};
+
+enum INDEX
+{
+  BRUTE_FORCE,
+  UNIFORM_GRID,
+  BOUNDING_VOLUMES
+};
+
+/**
+ * @brief Everything the background layer depends on, it is only drawn again once this changes
+ */
+struct BackgroundKey
+{
+  STATE state;
+  VISIBILITY visibilityMethod;
+  INDEX indexMethod;
+  TONE_MAP toneMap;
+  bool falloff;
+  int lightSamples;
+  uint64_t sceneGeneration;
+  olc::vi2d screenSize;
+
+  bool operator==(const BackgroundKey& other) const = default;
+};
+
+/**
+ * @brief What drawing mode puts on top of the background, kept so that it can be erased again
+ */
+struct EditOverlay
+{
+  bool highlight = false;
+  olc::vi2d highlightPoint;
+  bool selection = false;
+  olc::vi2d selectionStart;
+  olc::vi2d selectionEnd;
+
+  bool operator==(const EditOverlay& other) const = default;
+};
+
 class PGE_2d_shadow_casting : public olc::PixelGameEngine
 {
+  // Loads synthetic scenes straight into the internals, see bench/benchmark.cpp
+  friend class Benchmark;
+
 public:
   PGE_2d_shadow_casting()
   {
@@ -42,16 +110,79 @@ private:
   const int controlAreaHeight = 100;
   const int UIscaling = 2;
 
-  std::vector<line> lines;
+  EdgeStore lines;
+  std::vector<line> removedLines;
+  std::vector<light> lights;
+  std::vector<light> activeLights;
+  // Every light is an area light made of lightSamples points, with one polygon per point
+  std::vector<olc::vf2d> samplePositions;
+  std::vector<std::vector<olc::vf2d>> lightPolygons;
+  std::vector<size_t> uncachedLights;
+
+  // Radius of the disc the sample points of a light are scattered over, which sets the width of the penumbrae
+  const float lightRadius = 10.0f;
+  const int maxLightSamples = 32;
+  int lightSamples = 1;
+  std::vector<olc::vf2d> sampleOffsets = {{0.0f, 0.0f}};
+
+  // Bumped whenever a line changes, so that cached visibility polygons become stale
+  uint64_t sceneGeneration = 0;
+  VisibilityCache visibilityCache;
+  VisibilityPatcher visibilityPatcher;
+  // The light map is filled in tiles of rows, one worker of the pool per tile
+  TileRasterizer lightMap;
+
+  // Every worker of the pool gets its own solvers, as they keep scratch memory between calls
+  ThreadPool workers;
+  std::vector<std::unique_ptr<VisibilitySolver>> sweepSolvers;
+  std::vector<RayVisibility> raySolvers;
+
+  // Touching collinear lines are merged into single walls before anything sees them
+  OccluderOptimizer wallOptimizer{gridSize};
+  std::vector<Segment> retiredWalls;
+  std::vector<Segment> newWalls;
+
+  // The merged walls cut where they cross, shared by every light the sweep computes
+  CrossingSplitter wallSplitter;
+  uint64_t wallPiecesGeneration = 0;
+  bool wallPiecesSplit = false;
+
+  BruteForceIndex wallList;
+  UniformGrid wallGrid;
+  SegmentBVH wallTree;
   olc::vi2d selectedIntersection = {-1, -1};
   olc::vi2d mouse;
 
   STATE state = SELECT_AN_INTERSECTION;
+  VISIBILITY visibilityMethod = ANGULAR_SWEEP;
+  INDEX indexMethod = UNIFORM_GRID;
+  TONE_MAP toneMap = CLIP;
+  // Lights fade out towards half the diagonal of the screen
+  bool falloff = true;
 
   int diagonalDistance;
   int screenWidth;
   int screenHeight;
 
+  // The area lights are clipped to, which is the grid field below the control area
+  olc::vf2d boundsMin;
+  olc::vf2d boundsMax;
+
+  // The grid and the control area text sit on a layer behind the primary one
+  uint8_t backgroundLayer = 0;
+  BackgroundKey backgroundKey;
+  bool backgroundDrawn = false;
+
+  // In drawing mode the primary layer is only touched where the overlay changes, so that
+  // just that part of it is uploaded. It starts out opaque black and needs clearing once
+  EditOverlay editOverlay;
+  bool foregroundCleared = false;
+
+#if defined(SHADOW_PROFILE)
+  bool showProfile = true;
+  std::vector<ProfileSummary> profileSummary;
+#endif
+
 public:
   bool OnUserCreate() override
   {
@@ -61,20 +192,47 @@ public:
     screenWidth = ScreenWidth();
     screenHeight = ScreenHeight();
 
+    boundsMin = {0.0f, (float)controlAreaHeight};
+    boundsMax = {(float)screenWidth, (float)screenHeight};
+
+    wallGrid.Resize(screenWidth, screenHeight, gridSize);
+
+    // Smooth all the way, from full strength at the light to none at the end of its range
+    lightMap.SetFalloff(diagonalDistance / 2.0f, [](float distance) { return (1.0f - distance * distance) * (1.0f - distance * distance); });
+
+    backgroundLayer = (uint8_t)CreateLayer();
+    EnableLayer(backgroundLayer, true);
+
+    for (size_t i = 0; i < workers.Size(); i++)
+    {
+      sweepSolvers.push_back(std::make_unique<VisibilitySolver>());
+    }
+    raySolvers.resize(workers.Size());
+
     return true;
   }
 
   bool OnUserUpdate(float fElapsedTime) override
   {
+    PROFILE_FRAME();
+
     if (IsFocused())
     {
       mouse = {GetMouseX(), GetMouseY()};
 
       // TODO: integrate font extension of the PGE
-      // TODO: store lines using a hash function for efficient lookup times
-      UserInput();
-      UpdateState();
-      DrawToScreen();
+      {
+        PROFILE_ZONE("UserInput");
+        UserInput();
+      }
+      {
+        PROFILE_ZONE("UpdateState");
+        UpdateState();
+      }
+      {
+        PROFILE_ZONE("DrawToScreen");
+        DrawToScreen();
+      }
     }
 
     return true;
@@ -85,6 +243,20 @@ public:
    */
   void UserInput()
   {
+#if defined(SHADOW_PROFILE)
+    // Toggles the timing overlay and saves the recorded zones for chrome://tracing
+    if (GetKey(olc::P).bPressed)
+    {
+      showProfile = !showProfile;
+      foregroundCleared = false;
+    }
+
+    if (GetKey(olc::T).bPressed)
+    {
+      Profiler::Instance().ExportChromeTrace("trace.json");
+    }
+#endif
+
     // TODO: refactor this mess
     // Drawing mode
     if (state != CAST_LIGHT)
@@ -110,18 +282,17 @@ public:
           const olc::vi2d selected = {FindClosestMult(mouse.x), FindClosestMult(mouse.y)};
 
           // If the resulting line already exists, do nothing
-          for(const auto& line : lines)
+          const line created = {selectedIntersection.x, selectedIntersection.y, selected.x, selected.y};
+          if (!lines.Insert(created))
           {
-            if (
-              selectedIntersection.x == line.x1 && selectedIntersection.y == line.y1 && selected.x == line.x2 && selected.y == line.y2 ||
-              selectedIntersection.x == line.x2 && selectedIntersection.y == line.y2 && selected.x == line.x1 && selected.y == line.y1
-            )
-            {
-              return;
-            }
+            return;
           }
 
-          lines.push_back({selectedIntersection.x, selectedIntersection.y, selected.x, selected.y});
+          retiredWalls.clear();
+          newWalls.clear();
+          wallOptimizer.Insert(created, retiredWalls, newWalls);
+          UpdateOccluderIndices();
+          PatchCachedVisibility(ToSegment(created), true);
 
           // After creating a new line, deselect everything
           selectedIntersection = {-1, -1};
@@ -145,13 +316,16 @@ public:
           {
             const olc::vi2d selected = {FindClosestMult(mouse.x), FindClosestMult(mouse.y)};
 
-            for(std::vector<line>::iterator iterator = lines.begin(); iterator != lines.end(); iterator++)
+            removedLines.clear();
+            lines.EraseAtVertex(selected, removedLines);
+
+            for (const auto& removed : removedLines)
             {
-              if (selected.x == iterator->x1 && selected.y == iterator->y1 || selected.x == iterator->x2 && selected.y == iterator->y2)
-              {
-                lines.erase(iterator);
-                iterator--;
-              }
+              retiredWalls.clear();
+              newWalls.clear();
+              wallOptimizer.Remove(removed, retiredWalls, newWalls);
+              UpdateOccluderIndices();
+              PatchCachedVisibility(ToSegment(removed), false);
             }
           }
         }
@@ -160,7 +334,12 @@ public:
       // Pressing backspace clears all lines off the screen
       if (GetKey(olc::BACK).bPressed)
       {
-        lines.clear();
+        lines.Clear();
+        wallOptimizer.Clear();
+        wallList.Clear();
+        wallGrid.Clear();
+        wallTree.Clear();
+        sceneGeneration++;
       }
     }
     // Light casting mode
@@ -171,6 +350,117 @@ public:
         state = SELECT_AN_INTERSECTION;
         return;
       }
+
+      // Places a light at the mouse position
+      if (mouse.y > controlAreaHeight && GetMouse(0).bPressed)
+      {
+        const olc::Pixel palette[] = {olc::YELLOW, olc::CYAN, olc::GREEN, olc::RED, olc::BLUE, olc::MAGENTA};
+        lights.push_back({mouse, palette[lights.size() % 6]});
+      }
+
+      // Removes the light closest to the mouse if it is close enough
+      if (GetMouse(1).bPressed)
+      {
+        for (std::vector<light>::iterator iterator = lights.begin(); iterator != lights.end(); iterator++)
+        {
+          if ((iterator->position - mouse).mag2() <= 4 * circleRadius * circleRadius)
+          {
+            lights.erase(iterator);
+            break;
+          }
+        }
+      }
+
+      // Pressing backspace removes all placed lights
+      if (GetKey(olc::BACK).bPressed)
+      {
+        lights.clear();
+      }
+
+      // Switches between the two ways of computing the lit area
+      if (GetKey(olc::V).bPressed)
+      {
+        visibilityMethod = (visibilityMethod == ANGULAR_SWEEP) ? RAY_CASTING : ANGULAR_SWEEP;
+      }
+
+      // Switches the acceleration structure the rays are resolved with
+      if (GetKey(olc::I).bPressed)
+      {
+        indexMethod = (INDEX)((indexMethod + 1) % 3);
+      }
+
+      // Clipping keeps dim lights exact, the soft curve keeps bright overlaps from washing out
+      if (GetKey(olc::M).bPressed)
+      {
+        SetToneMap((toneMap == CLIP) ? SOFT : CLIP);
+      }
+
+      if (GetKey(olc::F).bPressed)
+      {
+        falloff = !falloff;
+      }
+
+      // More samples per light give smoother penumbrae, each one costs another visibility polygon
+      if (GetKey(olc::UP).bPressed)
+      {
+        SetLightSamples(lightSamples * 2);
+      }
+
+      if (GetKey(olc::DOWN).bPressed)
+      {
+        SetLightSamples(lightSamples / 2);
+      }
+    }
+  }
+
+  /**
+   * @brief Selects the curve the accumulated light is resolved to pixels with
+   */
+  void SetToneMap(const TONE_MAP curve)
+  {
+    toneMap = curve;
+
+    if (toneMap == SOFT)
+    {
+      // Starts out as the identity and approaches white without ever clipping
+      lightMap.SetToneMap([](float light) { return 255.0f * (1.0f - std::exp(-light / 255.0f)); });
+    }
+    else
+    {
+      lightMap.SetToneMap([](float light) { return light; });
+    }
+  }
+
+  /**
+   * @brief Scatters the sample points of the area lights over a disc of lightRadius
+   *
+   * Points follow a golden angle spiral with equal area per point, jittered within their
+   * share of the disc. The jitter is seeded, so the penumbrae do not shimmer from frame to
+   * frame and lights that do not move keep hitting the visibility cache. A single sample
+   * sits at the centre, which makes it the point light of old.
+   *
+   * @param samples Number of points per light, clamped to [1, maxLightSamples]
+   */
+  void SetLightSamples(const int samples)
+  {
+    lightSamples = std::clamp(samples, 1, maxLightSamples);
+    sampleOffsets.clear();
+
+    if (lightSamples == 1)
+    {
+      sampleOffsets.push_back({0.0f, 0.0f});
+      return;
+    }
+
+    std::mt19937 random(lightSamples);
+    std::uniform_real_distribution<float> jitter(0.0f, 1.0f);
+    const float goldenAngle = (float)M_PI * (3.0f - std::sqrt(5.0f));
+
+    for (int i = 0; i < lightSamples; i++)
+    {
+      const float radius = lightRadius * std::sqrt(((float)i + jitter(random)) / (float)lightSamples);
+      const float angle = ((float)i + jitter(random) - 0.5f) * goldenAngle;
+      sampleOffsets.push_back(olc::vf2d(std::cos(angle), std::sin(angle)) * radius);
     }
   }
 
@@ -187,39 +477,73 @@ public:
    */
   void DrawToScreen()
   {
-    Clear(olc::BLACK);
+    DrawBackground();
 
-    // Draws the grid only when in drawing mode
-    if (state != CAST_LIGHT)
+    // The primary layer is see-through wherever the background should show
+    if (!foregroundCleared)
     {
-      DrawGrid();
+      Clear(olc::BLANK);
+      editOverlay = {};
+      foregroundCleared = true;
     }
 
-    // Drawing a cricle around the intersection closest to the mouse position when in drawing mode
     if (state != CAST_LIGHT)
     {
-      HighlightNearestIntersection();
+      UpdateEditOverlay();
     }
     else
     {
+      // Lights are added onto black, which hides the grid field of the background
       CastLight();
+      foregroundCleared = false;
     }
 
-    // Draws all created lines
-    DrawLines();
+    // Uncovers the control area again wherever something has been drawn over it
+    const olc::Sprite* target = GetDrawTarget();
+    if (target->IsDirty() && target->vDirtyMin.y < controlAreaHeight)
+    {
+      FillRect(target->vDirtyMin.x, 0, target->vDirtyMax.x - target->vDirtyMin.x, controlAreaHeight, olc::BLANK);
+    }
 
-    // If an intersection has been selected
-    if (state == INTERSECTION_HAS_BEEN_SELECTED)
+#if defined(SHADOW_PROFILE)
+    if (showProfile)
     {
-      // Draws a line from the selected intersection to the highlighted one nearest to the mouse
-      DrawLine({gridSize * FindClosestMult(mouse.x), gridSize * FindClosestMult(mouse.y)}, selectedIntersection * gridSize, olc::CYAN);
+      DrawProfile();
+    }
+#endif
+  }
 
-      // Highlights the selected intersection
-      FillCircle(selectedIntersection * gridSize, circleRadius * 0.66f, olc::MAGENTA);
+  /**
+   * @brief Draws the grid and the control area onto the background layer when they have changed
+   */
+  void DrawBackground()
+  {
+    const BackgroundKey key = {state, visibilityMethod, indexMethod, toneMap, falloff, lightSamples, sceneGeneration, {ScreenWidth(), ScreenHeight()}};
+    if (backgroundDrawn && key == backgroundKey)
+    {
+      return;
     }
 
+    // Marks the layer for upload to the GPU, which happens only in frames it was drawn in
+    SetDrawTarget(backgroundLayer);
+    Clear(olc::BLACK);
+
+    // Draws the grid only when in drawing mode
+    if (state != CAST_LIGHT)
+    {
+      DrawGrid();
+    }
+
+    // Draws all created lines
+    DrawLines();
+
     // Draws the control area with text
     DrawControlArea();
+
+    SetDrawTarget(nullptr);
+
+    backgroundKey = key;
+    backgroundDrawn = true;
   }
 
   /**
@@ -262,18 +586,54 @@ public:
     // }
   }
 
+  /**
+   * @brief Replaces last frame's overlay with the current one, leaving the layer untouched when nothing moved
+   */
+  void UpdateEditOverlay()
+  {
+    const olc::vi2d nearest = {FindClosestMult(mouse.x), FindClosestMult(mouse.y)};
+
+    EditOverlay overlay;
+    overlay.highlight = mouse.y > controlAreaHeight;
+    overlay.highlightPoint = overlay.highlight ? nearest : olc::vi2d();
+    overlay.selection = state == INTERSECTION_HAS_BEEN_SELECTED;
+    overlay.selectionStart = overlay.selection ? selectedIntersection : olc::vi2d();
+    overlay.selectionEnd = overlay.selection ? nearest : olc::vi2d();
+
+    if (overlay == editOverlay)
+    {
+      return;
+    }
+
+    DrawEditOverlay(editOverlay, true);
+    DrawEditOverlay(overlay, false);
+    editOverlay = overlay;
+  }
+
   // TODO {optional}: implement deadzone
   /**
-   * @brief Highlights the nearest intersection to the mouse position with an orange circle
+   * @brief Draws the overlay of drawing mode
+   *
+   * Highlights the nearest intersection to the mouse position with an orange circle and
+   * connects it to the selected intersection, if there is one.
+   *
+   * @param overlay What to draw
+   * @param erase Draws it in transparent pixels instead, which removes it again
    */
-  void HighlightNearestIntersection()
+  void DrawEditOverlay(const EditOverlay& overlay, const bool erase)
   {
-    if (mouse.y > controlAreaHeight)
+    if (overlay.highlight)
     {
-      // Finding the closest multiples
-      const olc::vi2d point = {FindClosestMult(mouse.x), FindClosestMult(mouse.y)};
+      DrawCircle(overlay.highlightPoint * gridSize, circleRadius, erase ? olc::BLANK : olc::Pixel(255, 155, 0));
+    }
 
-      DrawCircle(point.x * gridSize, point.y * gridSize, circleRadius, olc::Pixel(255, 155, 0));
+    if (overlay.selection)
+    {
+      // Draws a line from the selected intersection to the highlighted one nearest to the mouse
+      DrawLine(overlay.selectionEnd * gridSize, overlay.selectionStart * gridSize, erase ? olc::BLANK : olc::CYAN);
+
+      // Highlights the selected intersection
+      FillCircle(overlay.selectionStart * gridSize, circleRadius * 0.66f, erase ? olc::BLANK : olc::MAGENTA);
     }
   }
 
@@ -310,8 +670,46 @@ public:
       FillRect(0, 0, 419, 25, olc::DARK_MAGENTA);
       DrawString(5, 5, "Mode:  D  [C] (cast light)", olc::CYAN, UIscaling);
       DrawStringProp(420, 5, "(change with RIGHT/LEFT)", olc::WHITE, UIscaling);
+
+      DrawStringProp(5, 30, (visibilityMethod == ANGULAR_SWEEP) ? "V - visibility: [sweep] rays" : "V - visibility: sweep [rays]", olc::WHITE, UIscaling);
+      const char* indexNames[] = {"I - ray index: [all] grid bvh", "I - ray index: all [grid] bvh", "I - ray index: all grid [bvh]"};
+      DrawStringProp(5, 55, indexNames[indexMethod], olc::WHITE, UIscaling);
+      DrawStringProp(640, 30, "UP/DOWN - samples per light: " + std::to_string(lightSamples), olc::WHITE, UIscaling);
+      DrawStringProp(640, 55, (toneMap == CLIP) ? "M - tone map: [clip] soft" : "M - tone map: clip [soft]", olc::WHITE, UIscaling);
+      DrawStringProp(780, 5, falloff ? "F - falloff: [on] off" : "F - falloff: on [off]", olc::WHITE, UIscaling);
+      DrawStringProp(5, 80, "M1 - place a light, M2 - remove it, BACKSPACE - remove all", olc::WHITE, UIscaling);
+    }
+  }
+
+#if defined(SHADOW_PROFILE)
+  /**
+   * @brief Lists the time every zone took, averaged over the last 30 frames, at the right of the control area
+   */
+  void DrawProfile()
+  {
+    Profiler::Instance().Summarize(30, profileSummary);
+
+    const int x = screenWidth - 230;
+    FillRect(x - 5, 0, 235, controlAreaHeight, olc::Pixel(64, 0, 128));
+    DrawString(x, 4, "ms  (P hide, T trace)", olc::CYAN);
+
+    int y = 16;
+    for (const auto& zone : profileSummary)
+    {
+      if (y > controlAreaHeight - 8)
+      {
+        break;
+      }
+
+      // Nested zones are indented below the zone they were opened in
+      const int indent = 2 * (int)std::min(zone.depth, 4u);
+      char text[64];
+      std::snprintf(text, sizeof(text), "%*s%-*s%7.3f", indent, "", 18 - indent, zone.name, zone.milliseconds);
+      DrawString(x, y, text, olc::WHITE);
+      y += 10;
     }
   }
+#endif
 
   /**
    * @brief Finds the closest multiple to the input number
@@ -334,97 +732,240 @@ public:
   }
 
   /**
-   * @brief Draws the light
+   * @brief Converts a line from grid coordinates into a wall in screen space
+   *
+   * @param line The line to convert
+   * @return Segment The wall in pixels
    */
-  void CastLight()
+  Segment ToSegment(const line& line) const
+  {
+    return {
+      {(float)(line.x1 * gridSize), (float)(line.y1 * gridSize)},
+      {(float)(line.x2 * gridSize), (float)(line.y2 * gridSize)}
+    };
+  }
+
+  /**
+   * @brief Applies the walls the optimizer retired and created to every acceleration structure
+   *
+   * A wall that grows or shrinks by a cell retires the old wall and creates one sharing an
+   * end with it. The bounding volume hierarchy moves the old wall onto the new one instead,
+   * which refits a few boxes rather than rebuilding the whole tree.
+   */
+  void UpdateOccluderIndices()
   {
-    const olc::vi2d invalid = {-1, -1};
+    std::vector<bool> moved(retiredWalls.size(), false);
 
-    // TODO: implement javidx9's solution
-    // Calculates all triangles that should represent the light
-    for (const auto &line : lines)
+    for (const auto& wall : retiredWalls)
     {
-      // Draws the lines the user has created
-      DrawLine(line.x1 * gridSize, line.y1 * gridSize, line.x2 * gridSize, line.y2 * gridSize, olc::MAGENTA);
+      wallList.Remove(wall);
+      wallGrid.Remove(wall);
+    }
 
-      // The two iterations are for the line start and line end
-      for (int i = 0; i < 2; i++)
-      {
-        olc::vf2d ray;
+    for (const auto& wall : newWalls)
+    {
+      wallList.Insert(wall);
+      wallGrid.Insert(wall);
 
-        switch (i)
+      bool paired = false;
+      for (size_t i = 0; i < retiredWalls.size() && !paired; i++)
+      {
+        const Segment& retired = retiredWalls[i];
+        if (!moved[i] && (retired.start == wall.start || retired.start == wall.end || retired.end == wall.start || retired.end == wall.end))
         {
-          // Line start
-          case 0:
-            ray.x = ((float)line.x1 * (float)gridSize) - (float)mouse.x;
-            ray.y = ((float)line.y1 * (float)gridSize) - (float)mouse.y;
-          break;
-
-          // Line end
-          case 1:
-            ray.x = ((float)line.x2 * (float)gridSize) - (float)mouse.x;
-            ray.y = ((float)line.y2 * (float)gridSize) - (float)mouse.y;
-          break;
-
-          default:
-          break;
+          wallTree.Move(retired, wall);
+          moved[i] = true;
+          paired = true;
         }
+      }
 
-        float baseAngle = atan2f(ray.x, ray.y);
+      if (!paired)
+      {
+        wallTree.Insert(wall);
+      }
+    }
 
-        float angle = 0;
+    for (size_t i = 0; i < retiredWalls.size(); i++)
+    {
+      if (!moved[i])
+      {
+        wallTree.Remove(retiredWalls[i]);
+      }
+    }
+  }
 
-        // For each point cast 3 rays
-        for (int j = 0; j < 3; j++)
-        {
-          switch (j)
-          {
-            case 0:
-              angle = baseAngle - 0.0001f;
-            break;
+  /**
+   * @brief Returns the acceleration structure currently selected for ray casting
+   */
+  OccluderIndex& GetOccluderIndex()
+  {
+    switch (indexMethod)
+    {
+      case UNIFORM_GRID:
+        return wallGrid;
 
-            case 1:
-              angle = baseAngle;
-            break;
+      case BOUNDING_VOLUMES:
+        return wallTree;
 
-            case 2:
-              angle = baseAngle + 0.0001f;
-            break;
+      default:
+        return wallList;
+    }
+  }
 
-            default:
-            break;
-          }
+  /**
+   * @brief Advances the scene generation after a single line was added or removed
+   *
+   * Instead of recomputing them, the polygons of the lights shown last are patched in the
+   * directions the line covers and carried over to the new generation.
+   *
+   * @param wall The line that changed, in screen space
+   * @param added Whether the line was added or removed
+   */
+  void PatchCachedVisibility(const Segment& wall, const bool added)
+  {
+    const uint64_t previousGeneration = sceneGeneration++;
 
-          // Create ray along angle for required distance
-          ray.x = (float)diagonalDistance * cosf(angle);
-          ray.y = (float)diagonalDistance * sinf(angle);
+    visibilityCache.Patch(previousGeneration, sceneGeneration, (lights.size() + 1) * sampleOffsets.size(), [&](const olc::vf2d& position, int variant, std::vector<olc::vf2d>& polygon)
+    {
+      // Polygons cast with rays carry tiny angular offsets, those are simply recomputed
+      if (variant != ANGULAR_SWEEP)
+      {
+        return false;
+      }
 
-          // Check for ray intersection with all edges
-          for (const auto &line2 : lines)
-          {
-            olc::vf2d start = {(float)line2.x1, (float)line2.y1};
-            olc::vf2d end = {(float)line2.x2, (float)line2.y2};
+      if (added)
+      {
+        return visibilityPatcher.InsertWall(*sweepSolvers[0], position, wall, boundsMin, boundsMax, polygon);
+      }
 
-            olc::vf2d intersection = CalculateIntersection(mouse, ray, start, end);
-          }
+      return visibilityPatcher.RemoveWall(*sweepSolvers[0], position, wall, wallGrid, boundsMin, boundsMax, polygon);
+    });
+  }
+
+  /**
+   * @brief Cuts the merged walls where they cross, once for every scene generation
+   */
+  void SplitWalls(const std::vector<Segment>& occluders)
+  {
+    if (wallPiecesSplit && wallPiecesGeneration == sceneGeneration)
+    {
+      return;
+    }
+
+    PROFILE_ZONE("SplitWalls");
+    wallSplitter.Split(occluders, boundsMin, boundsMax);
+    wallPiecesGeneration = sceneGeneration;
+    wallPiecesSplit = true;
+  }
+
+  /**
+   * @brief Draws the light
+   */
+  void CastLight()
+  {
+    PROFILE_ZONE("CastLight");
+
+    // Every placed light shines, plus one at the mouse while it is on the grid field
+    activeLights = lights;
+    if (mouse.y > controlAreaHeight)
+    {
+      activeLights.push_back({mouse, olc::WHITE});
+    }
+
+    // The merged walls are only gathered again after the lines changed
+    const std::vector<Segment>& occluders = wallOptimizer.Segments();
+
+    OccluderIndex& index = GetOccluderIndex();
+
+    // Every sample point of a light gets its own polygon, those that have not moved since
+    // the last change to the lines are already known
+    const size_t samples = sampleOffsets.size();
+    samplePositions.resize(activeLights.size() * samples);
+    lightPolygons.resize(samplePositions.size());
+    uncachedLights.clear();
+    for (size_t i = 0; i < samplePositions.size(); i++)
+    {
+      // Points that would fall off the grid field are kept just inside it, a light on the
+      // edge itself gets no polygon from the solver
+      const olc::vf2d position = (olc::vf2d(activeLights[i / samples].position) + sampleOffsets[i % samples]).max(boundsMin + olc::vf2d(1.0f, 1.0f)).min(boundsMax - olc::vf2d(1.0f, 1.0f));
+      samplePositions[i] = visibilityCache.Quantize(position);
+
+      if (!visibilityCache.Find(samplePositions[i], sceneGeneration, visibilityMethod, lightPolygons[i]))
+      {
+        uncachedLights.push_back(i);
+      }
+    }
+
+    {
+      PROFILE_ZONE("Visibility");
+
+      if (!uncachedLights.empty())
+      {
+        if (visibilityMethod == ANGULAR_SWEEP)
+        {
+          SplitWalls(occluders);
+        }
+        else
+        {
+          index.Prepare();
+        }
+      }
+
+      // The sample points are independent of each other and share the index, so each one is a job for the pool
+      workers.ParallelFor(uncachedLights.size(), [&](size_t job, size_t worker)
+      {
+        const size_t i = uncachedLights[job];
+
+        if (visibilityMethod == ANGULAR_SWEEP)
+        {
+          sweepSolvers[worker]->Compute(samplePositions[i], wallSplitter, boundsMin, boundsMax, lightPolygons[i]);
+        }
+        else
+        {
+          raySolvers[worker].Compute(samplePositions[i], occluders, index, boundsMin, boundsMax, lightPolygons[i]);
         }
+      });
+
+      for (const size_t i : uncachedLights)
+      {
+        visibilityCache.Store(samplePositions[i], sceneGeneration, visibilityMethod, lightPolygons[i]);
       }
-      // const olc::vi2d point1 = {line.x1 * gridSize, line.y1 * gridSize};
-      // const olc::vi2d point2 = {line.x2 * gridSize, line.y2 * gridSize};
+    }
 
-      // // Determine two points outside the viewport
-      // const olc::vi2d distantPoint1 = FindSuitablePoint(point1);
-      // const olc::vi2d distantPoint2 = FindSuitablePoint(point2);
+    {
+      PROFILE_ZONE("Rasterize");
 
-      // int distance1;
-      // int distance2;
+      // Accumulates the area lit by each sample point onto black, overlapping lights add up
+      lightMap.Begin({0, controlAreaHeight}, {screenWidth, screenHeight});
+      for (size_t i = 0; i < lightPolygons.size(); i++)
+      {
+        const olc::Pixel& colour = activeLights[i / samples].colour;
+        const LightValue light = LightValue::FromPixel(olc::Pixel(colour.r / 3, colour.g / 3, colour.b / 3));
+        // Sample k gets (c + k) / K, which sums up to exactly c over all samples of a light
+        const uint32_t k = (uint32_t)(i % samples);
+        const LightValue share = {(uint16_t)((light.r + k) / samples), (uint16_t)((light.g + k) / samples), (uint16_t)((light.b + k) / samples)};
 
-      // olc::vi2d distance;
+        if (falloff)
+        {
+          lightMap.Bin(lightPolygons[i], share, samplePositions[i]);
+        }
+        else
+        {
+          lightMap.Bin(lightPolygons[i], share);
+        }
+      }
+      lightMap.Render(workers, GetDrawTarget(), olc::BLACK);
+    }
 
-      // DrawLine(mouse, distantPoint1, olc::MAGENTA);
-      // DrawLine(mouse, distantPoint2, olc::MAGENTA);
+    // Draws the lines the user has created
+    for (const auto& line : lines)
+    {
+      DrawLine(line.x1 * gridSize, line.y1 * gridSize, line.x2 * gridSize, line.y2 * gridSize, olc::MAGENTA);
+    }
 
-      // DrawLine(point1, point2, olc::CYAN);
+    for (const auto& light : activeLights)
+    {
+      FillCircle(light.position, circleRadius / 2, light.colour);
     }
   }
 
@@ -529,10 +1070,102 @@ public:
   }
 };
 
-int main()
+#if !defined(PGE_SHADOW_CASTING_NO_MAIN)
+/**
+ * @brief Scripts a scene for headless runs: a few walls, three placed lights and a light
+ * circling around with the mouse for the remaining frames
+ */
+void ScriptDemoScene(HeadlessDriver& driver, const uint32_t frames)
 {
+  const std::vector<std::pair<olc::vi2d, olc::vi2d>> walls = {
+    {{200, 200}, {500, 200}},
+    {{500, 200}, {500, 400}},
+    {{800, 300}, {1000, 500}},
+    {{300, 600}, {700, 600}},
+    {{1100, 200}, {1100, 700}},
+    {{600, 400}, {600, 500}}
+  };
+
+  uint32_t frame = 0;
+  for (const auto& wall : walls)
+  {
+    driver.Click(frame, wall.first);
+    driver.Click(frame + 2, wall.second);
+    frame += 4;
+  }
+
+  driver.Tap(frame, olc::RIGHT);
+  frame += 2;
+
+  for (const olc::vi2d& position : {olc::vi2d{400, 300}, olc::vi2d{900, 650}, olc::vi2d{150, 750}})
+  {
+    driver.Click(frame, position);
+    frame += 2;
+  }
+
+  for (; frame < frames; frame++)
+  {
+    const float angle = frame * 0.05f;
+    driver.MoveMouse(frame, {640 + (int)(400.0f * std::cos(angle)), 460 + (int)(300.0f * std::sin(angle))});
+  }
+}
+
+/**
+ * Usage: PGE_2d_shadow_casting [--headless frames] [--software] [--output file.ppm]
+ *
+ * With --headless no window is opened, a scripted scene runs for the given number of
+ * frames at a fixed time step and the last frame can be written to a file. With
+ * --software every frame is also composited on the CPU, and that is what gets written.
+ */
+int main(int argc, char* argv[])
+{
+  uint32_t headlessFrames = 0;
+  bool software = false;
+  std::string output;
+
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string argument = argv[i];
+
+    if (argument == "--headless" && i + 1 < argc)
+    {
+      headlessFrames = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+    }
+    else if (argument == "--software")
+    {
+      software = true;
+    }
+    else if (argument == "--output" && i + 1 < argc)
+    {
+      output = argv[++i];
+    }
+  }
+
   PGE_2d_shadow_casting demo;
 
+  if (headlessFrames > 0)
+  {
+    olc::Sprite frame;
+    demo.olc_ConfigureHeadless(software ? &frame : nullptr);
+
+    if (!demo.Construct(1280, 820, 1, 1))
+    {
+      return 1;
+    }
+
+    HeadlessDriver driver(demo);
+    ScriptDemoScene(driver, headlessFrames);
+    const uint32_t ran = driver.Run(headlessFrames);
+    std::printf("%u frames\n", ran);
+
+    if (!output.empty() && !driver.SaveFrame(output, software ? &frame : nullptr))
+    {
+      return 1;
+    }
+
+    return 0;
+  }
+
   if (demo.Construct(1280, 820, 1, 1, false, true))
   {
     demo.Start();
@@ -540,3 +1173,4 @@ int main()
 
   return 0;
 }
+#endif
@@ -0,0 +1,554 @@
+#pragma once
+
+#include "olcPixelGameEngine.h"
+#include "occluder_index.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief A bounding volume hierarchy over walls, built with the surface area heuristic
+ *
+ * Unlike the uniform grid it adapts to how the walls are distributed, so dense clusters
+ * of walls next to large empty areas stay cheap to trace. Edits only mark the tree as
+ * stale, it is rebuilt once by Prepare() before the next batch of rays. Walls that merely
+ * move can be updated in place with Move(), which refits the existing boxes instead.
+ *
+ * Every leaf starts on a fresh run of eight slots in a SegmentBlock, so a leaf is tested
+ * with the same batched kernels as the brute force list and leaves hold as many walls as
+ * the surface area heuristic finds cheaper than splitting them further.
+ */
+class SegmentBVH : public OccluderIndex
+{
+public:
+  void Insert(const Segment& segment) override
+  {
+    segments.push_back(segment);
+    dirty = true;
+  }
+
+  void Remove(const Segment& segment) override
+  {
+    for (size_t i = 0; i < segments.size(); i++)
+    {
+      if (SameSegment(segments[i], segment))
+      {
+        segments[i] = segments.back();
+        segments.pop_back();
+        dirty = true;
+        return;
+      }
+    }
+  }
+
+  void Clear() override
+  {
+    segments.clear();
+    dirty = true;
+  }
+
+  void Prepare() override
+  {
+    if (dirty)
+    {
+      Build();
+      dirty = false;
+    }
+  }
+
+  /**
+   * @brief Moves a wall without rebuilding the tree, the boxes are refitted around it
+   *
+   * The wall is found through a hash map and only the boxes of its leaf and the leaf's
+   * ancestors are refitted. The tree stays valid but gets less efficient the further walls
+   * drift from where they were at build time, so large changes are better handled by
+   * Remove() and Insert(). A tree that is about to be rebuilt just takes the new wall.
+   *
+   * @param from The wall as it is currently stored
+   * @param to The new position of the wall
+   */
+  void Move(const Segment& from, const Segment& to)
+  {
+    if (dirty)
+    {
+      for (auto& segment : segments)
+      {
+        if (SameSegment(segment, from))
+        {
+          segment = to;
+          return;
+        }
+      }
+      return;
+    }
+
+    const auto found = slots.find(KeyOf(from));
+    if (found == slots.end())
+    {
+      return;
+    }
+
+    const int slot = found->second;
+    slots.erase(found);
+    slots.emplace(KeyOf(to), slot);
+
+    segments[slotSources[slot]] = to;
+    leafSegments[slot] = to;
+    block.Set(slot, to);
+
+    // Going up, a box that comes out the same leaves every box above it unchanged too
+    for (int current = slotLeaves[slot]; current != -1; current = parents[current])
+    {
+      const Box box = Fit(nodes[current]);
+      const Box& previous = nodes[current].box;
+      if (box.minX == previous.minX && box.minY == previous.minY && box.maxX == previous.maxX && box.maxY == previous.maxY)
+      {
+        break;
+      }
+      nodes[current].box = box;
+    }
+  }
+
+  /**
+   * @brief Recomputes every box bottom-up from the walls currently stored in the leaves
+   */
+  void Refit()
+  {
+    // Children are always stored after their parent
+    for (int i = (int)nodes.size() - 1; i >= 0; i--)
+    {
+      nodes[i].box = Fit(nodes[i]);
+    }
+  }
+
+  RayHit Raycast(const olc::vf2d& origin, const olc::vf2d& ray, const float maxT) const override
+  {
+    RayHit best = {maxT, -1};
+
+    if (nodes.empty())
+    {
+      return best;
+    }
+
+    // Few walls end up in a single leaf, its box would only cost another test
+    if (nodes[0].count > 0)
+    {
+      return NearestHit(block, 0, block.Padded(), origin, ray, best);
+    }
+
+    const olc::vf2d inverse = {1.0f / ray.x, 1.0f / ray.y};
+
+    std::array<int, maxDepth + 2> stack;
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0)
+    {
+      const int current = stack[--top];
+      const Node& node = nodes[current];
+
+      if (Enter(node.box, origin, inverse, best.t) >= best.t)
+      {
+        continue;
+      }
+
+      if (node.count > 0)
+      {
+        best = NearestHit(block, node.first, node.first + SegmentBlock::Padded(node.count), origin, ray, best);
+        continue;
+      }
+
+      // Visit the nearer child first so that the farther one is likely culled
+      const int left = current + 1;
+      const int right = node.first;
+      const float enterLeft = Enter(nodes[left].box, origin, inverse, best.t);
+      const float enterRight = Enter(nodes[right].box, origin, inverse, best.t);
+
+      if (enterLeft < enterRight)
+      {
+        stack[top++] = right;
+        stack[top++] = left;
+      }
+      else
+      {
+        stack[top++] = left;
+        stack[top++] = right;
+      }
+    }
+
+    return best;
+  }
+
+  /**
+   * @brief Collects the walls whose leaves overlap a box, the tree has to be prepared
+   */
+  void Query(const olc::vf2d& boxMin, const olc::vf2d& boxMax, std::vector<Segment>& found) const override
+  {
+    if (nodes.empty())
+    {
+      return;
+    }
+
+    std::array<int, maxDepth + 2> stack;
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0)
+    {
+      const int current = stack[--top];
+      const Node& node = nodes[current];
+
+      if (node.box.maxX < boxMin.x || node.box.minX > boxMax.x || node.box.maxY < boxMin.y || node.box.minY > boxMax.y)
+      {
+        continue;
+      }
+
+      if (node.count > 0)
+      {
+        for (int i = node.first; i < node.first + node.count; i++)
+        {
+          if (SegmentOverlapsBox(leafSegments[i], boxMin, boxMax))
+          {
+            found.push_back(leafSegments[i]);
+          }
+        }
+        continue;
+      }
+
+      stack[top++] = current + 1;
+      stack[top++] = node.first;
+    }
+  }
+
+private:
+  struct Box
+  {
+    float minX;
+    float minY;
+    float maxX;
+    float maxY;
+
+    static Box Empty()
+    {
+      const float infinity = std::numeric_limits<float>::infinity();
+      return {infinity, infinity, -infinity, -infinity};
+    }
+
+    void Grow(const olc::vf2d& point)
+    {
+      minX = std::min(minX, point.x);
+      minY = std::min(minY, point.y);
+      maxX = std::max(maxX, point.x);
+      maxY = std::max(maxY, point.y);
+    }
+
+    void Grow(const Segment& segment)
+    {
+      Grow(segment.start);
+      Grow(segment.end);
+    }
+
+    void Grow(const Box& box)
+    {
+      minX = std::min(minX, box.minX);
+      minY = std::min(minY, box.minY);
+      maxX = std::max(maxX, box.maxX);
+      maxY = std::max(maxY, box.maxY);
+    }
+
+    // The 2D equivalent of surface area
+    float Perimeter() const
+    {
+      return (maxX < minX) ? 0.0f : 2.0f * ((maxX - minX) + (maxY - minY));
+    }
+  };
+
+  /**
+   * @brief Interior nodes keep their right child in first, the left one follows directly
+   *
+   * Leaves keep their first slot in the block instead, count never includes the padding.
+   */
+  struct Node
+  {
+    Box box;
+    int first;
+    int count;
+  };
+
+  static constexpr int binCount = 16;
+  static constexpr int maxDepth = 62;
+
+  // Relative costs of visiting an interior node, which tests the boxes of both children,
+  // and of testing one run of eight walls in a leaf
+  static constexpr float traversalCost = 4.0f;
+  static constexpr float intersectionCost = 1.0f;
+
+  /**
+   * @brief A wall with its ends in a fixed order, so both directions find the same entry
+   */
+  struct WallKey
+  {
+    float x1;
+    float y1;
+    float x2;
+    float y2;
+
+    bool operator==(const WallKey& other) const
+    {
+      return x1 == other.x1 && y1 == other.y1 && x2 == other.x2 && y2 == other.y2;
+    }
+  };
+
+  struct WallKeyHash
+  {
+    size_t operator()(const WallKey& key) const
+    {
+      uint64_t hash = 0;
+      for (const float coordinate : {key.x1, key.y1, key.x2, key.y2})
+      {
+        uint32_t bits;
+        std::memcpy(&bits, &coordinate, sizeof(bits));
+        hash ^= (uint64_t)bits + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+      }
+      return (size_t)hash;
+    }
+  };
+
+  std::vector<Segment> segments;
+  std::vector<Segment> leafSegments;
+  SegmentBlock block;
+  std::vector<Node> nodes;
+  // Parent of every node, -1 for the root
+  std::vector<int> parents;
+  // For every slot of the block the leaf holding it and the index of its wall in segments,
+  // both -1 for padding
+  std::vector<int> slotLeaves;
+  std::vector<int> slotSources;
+  // Slot of every wall while the tree is up to date, a wall stored twice has two entries
+  std::unordered_multimap<WallKey, int, WallKeyHash> slots;
+  std::vector<int> order;
+  std::vector<olc::vf2d> centres;
+  bool dirty = false;
+
+  static WallKey KeyOf(const Segment& segment)
+  {
+    // Adding zero turns -0 into 0, which compares equal but hashes differently
+    olc::vf2d first = segment.start + olc::vf2d(0.0f, 0.0f);
+    olc::vf2d second = segment.end + olc::vf2d(0.0f, 0.0f);
+    if (second.x < first.x || (second.x == first.x && second.y < first.y))
+    {
+      std::swap(first, second);
+    }
+    return {first.x, first.y, second.x, second.y};
+  }
+
+  /**
+   * @brief The box around the walls of a leaf or the boxes of an interior node's children
+   */
+  Box Fit(const Node& node) const
+  {
+    Box box = Box::Empty();
+    if (node.count > 0)
+    {
+      for (int i = node.first; i < node.first + node.count; i++)
+      {
+        box.Grow(leafSegments[i]);
+      }
+    }
+    else
+    {
+      box = nodes[&node - nodes.data() + 1].box;
+      box.Grow(nodes[node.first].box);
+    }
+    return box;
+  }
+
+  /**
+   * @brief Where a ray enters a box, or infinity if it misses it before limit
+   */
+  static float Enter(const Box& box, const olc::vf2d& origin, const olc::vf2d& inverse, const float limit)
+  {
+    float x0 = (box.minX - origin.x) * inverse.x;
+    float x1 = (box.maxX - origin.x) * inverse.x;
+    float y0 = (box.minY - origin.y) * inverse.y;
+    float y1 = (box.maxY - origin.y) * inverse.y;
+
+    // 0 * infinity happens for rays along a box edge, count those as inside
+    if (std::isnan(x0) || std::isnan(x1))
+    {
+      x0 = -std::numeric_limits<float>::infinity();
+      x1 = std::numeric_limits<float>::infinity();
+    }
+    if (std::isnan(y0) || std::isnan(y1))
+    {
+      y0 = -std::numeric_limits<float>::infinity();
+      y1 = std::numeric_limits<float>::infinity();
+    }
+
+    const float enter = std::max({std::min(x0, x1), std::min(y0, y1), 0.0f});
+    const float exit = std::min({std::max(x0, x1), std::max(y0, y1), limit});
+
+    return (enter <= exit) ? enter : std::numeric_limits<float>::infinity();
+  }
+
+  void Build()
+  {
+    nodes.clear();
+    parents.clear();
+    leafSegments.clear();
+    slotLeaves.clear();
+    slotSources.clear();
+    slots.clear();
+    block.Clear();
+
+    if (segments.empty())
+    {
+      return;
+    }
+
+    order.resize(segments.size());
+    centres.resize(segments.size());
+    for (int i = 0; i < (int)segments.size(); i++)
+    {
+      order[i] = i;
+      centres[i] = (segments[i].start + segments[i].end) * 0.5f;
+    }
+
+    nodes.reserve(2 * segments.size());
+    parents.reserve(2 * segments.size());
+    Split(0, (int)segments.size(), 0, -1);
+  }
+
+  /**
+   * @brief Testing cost of a leaf with this many walls, padding is tested all the same
+   */
+  static float LeafCost(const int count)
+  {
+    return intersectionCost * (float)SegmentBlock::Padded((size_t)count) / SegmentBlock::lanes;
+  }
+
+  /**
+   * @brief Turns a node into a leaf over order[first, last) and moves its walls to the block
+   */
+  int Leaf(const int index, const int first, const int last)
+  {
+    nodes[index].first = (int)block.count;
+    for (int i = first; i < last; i++)
+    {
+      slots.emplace(KeyOf(segments[order[i]]), (int)block.count);
+      block.Add(segments[order[i]]);
+      leafSegments.push_back(segments[order[i]]);
+      slotLeaves.push_back(index);
+      slotSources.push_back(order[i]);
+    }
+    block.Pad();
+    leafSegments.resize(block.count);
+    slotLeaves.resize(block.count, -1);
+    slotSources.resize(block.count, -1);
+
+    return index;
+  }
+
+  /**
+   * @brief Builds the subtree over order[first, last) below parent and returns its node index
+   */
+  int Split(const int first, const int last, const int depth, const int parent)
+  {
+    const int index = (int)nodes.size();
+    nodes.push_back({Box::Empty(), first, last - first});
+    parents.push_back(parent);
+
+    Box bounds = Box::Empty();
+    Box centreBounds = Box::Empty();
+    for (int i = first; i < last; i++)
+    {
+      bounds.Grow(segments[order[i]]);
+      centreBounds.Grow(centres[order[i]]);
+    }
+    nodes[index].box = bounds;
+
+    const int count = last - first;
+    if (count == 1 || depth >= maxDepth)
+    {
+      return Leaf(index, first, last);
+    }
+
+    // Bin the centres along the longer axis and pick the cheapest split between bins
+    const bool alongX = (centreBounds.maxX - centreBounds.minX) >= (centreBounds.maxY - centreBounds.minY);
+    const float low = alongX ? centreBounds.minX : centreBounds.minY;
+    const float extent = (alongX ? centreBounds.maxX : centreBounds.maxY) - low;
+
+    // Every wall sits at the same spot, no split can separate them
+    if (extent <= 0.0f)
+    {
+      return Leaf(index, first, last);
+    }
+
+    auto Bin = [&](const int segment)
+    {
+      const float centre = alongX ? centres[segment].x : centres[segment].y;
+      return std::min(binCount - 1, (int)((centre - low) / extent * binCount));
+    };
+
+    std::array<Box, binCount> binBoxes;
+    std::array<int, binCount> binCounts = {};
+    binBoxes.fill(Box::Empty());
+    for (int i = first; i < last; i++)
+    {
+      const int bin = Bin(order[i]);
+      binBoxes[bin].Grow(segments[order[i]]);
+      binCounts[bin]++;
+    }
+
+    std::array<float, binCount> costBelow;
+    Box below = Box::Empty();
+    int countBelow = 0;
+    for (int bin = 0; bin < binCount - 1; bin++)
+    {
+      below.Grow(binBoxes[bin]);
+      countBelow += binCounts[bin];
+      costBelow[bin] = below.Perimeter() * LeafCost(countBelow);
+    }
+
+    float bestCost = std::numeric_limits<float>::infinity();
+    int bestBin = -1;
+    Box above = Box::Empty();
+    int countAbove = 0;
+    for (int bin = binCount - 1; bin > 0; bin--)
+    {
+      above.Grow(binBoxes[bin]);
+      countAbove += binCounts[bin];
+
+      const float cost = costBelow[bin - 1] + above.Perimeter() * LeafCost(countAbove);
+      if (cost < bestCost)
+      {
+        bestCost = cost;
+        bestBin = bin;
+      }
+    }
+
+    // Splitting has to beat testing every wall in a single leaf even after paying for the
+    // extra node, both sides are scaled by the perimeter of this node
+    if (bestBin == -1 || traversalCost * bounds.Perimeter() + bestCost >= bounds.Perimeter() * LeafCost(count))
+    {
+      return Leaf(index, first, last);
+    }
+
+    const int middle = (int)(std::partition(order.begin() + first, order.begin() + last, [&](const int segment) { return Bin(segment) < bestBin; }) - order.begin());
+    if (middle == first || middle == last)
+    {
+      return Leaf(index, first, last);
+    }
+
+    nodes[index].count = 0;
+    Split(first, middle, depth + 1, index);
+    nodes[index].first = Split(middle, last, depth + 1, index);
+
+    return index;
+  }
+};
@@ -0,0 +1,299 @@
+#pragma once
+
+#include "olcPixelGameEngine.h"
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief A line between two grid intersections, in grid coordinates
+ */
+struct line
+{
+  int x1;
+  int y1;
+  int x2;
+  int y2;
+};
+
+/**
+ * @brief Stores lines contiguously while indexing them by endpoints
+ *
+ * Lines live in a plain array for fast iteration and are removed by swapping with the
+ * last one. An open-addressing hash table over the endpoint pair (in either direction)
+ * finds duplicates in O(1), and an endpoint to lines index finds every line ending at an
+ * intersection without scanning the whole map.
+ */
+class EdgeStore
+{
+public:
+  std::vector<line>::const_iterator begin() const
+  {
+    return lines.begin();
+  }
+
+  std::vector<line>::const_iterator end() const
+  {
+    return lines.end();
+  }
+
+  size_t size() const
+  {
+    return lines.size();
+  }
+
+  bool empty() const
+  {
+    return lines.empty();
+  }
+
+  const line& operator[](const size_t index) const
+  {
+    return lines[index];
+  }
+
+  bool Contains(const line& edge) const
+  {
+    return Find(edge) != -1;
+  }
+
+  /**
+   * @brief Adds a line unless it (or its reverse) is already stored
+   *
+   * @return bool Whether the line was added
+   */
+  bool Insert(const line& edge)
+  {
+    if (Contains(edge))
+    {
+      return false;
+    }
+
+    // Keep at most half of the table in use, tombstones included
+    if ((used + 1) * 2 > table.size())
+    {
+      Rehash(std::max<size_t>(16, lines.size() * 4));
+    }
+
+    const int index = (int)lines.size();
+    lines.push_back(edge);
+    Claim(edge, index);
+
+    endpoints[Vertex(edge.x1, edge.y1)].push_back(index);
+    if (edge.x1 != edge.x2 || edge.y1 != edge.y2)
+    {
+      endpoints[Vertex(edge.x2, edge.y2)].push_back(index);
+    }
+
+    return true;
+  }
+
+  /**
+   * @brief Removes a line (in either direction)
+   *
+   * @return bool Whether the line was stored
+   */
+  bool Erase(const line& edge)
+  {
+    const int index = Find(edge);
+    if (index == -1)
+    {
+      return false;
+    }
+
+    EraseAt(index);
+    return true;
+  }
+
+  /**
+   * @brief Removes every line that ends at an intersection
+   *
+   * @param vertex The intersection in grid coordinates
+   * @param removed The removed lines are appended to this
+   */
+  void EraseAtVertex(const olc::vi2d& vertex, std::vector<line>& removed)
+  {
+    const auto found = endpoints.find(Vertex(vertex.x, vertex.y));
+    if (found == endpoints.end())
+    {
+      return;
+    }
+
+    // Erasing swaps lines around, so look each one up again by value
+    const std::vector<int> indices = found->second;
+    std::vector<line> doomed;
+    for (const int index : indices)
+    {
+      doomed.push_back(lines[index]);
+    }
+
+    for (const auto& edge : doomed)
+    {
+      if (Erase(edge))
+      {
+        removed.push_back(edge);
+      }
+    }
+  }
+
+  void Clear()
+  {
+    lines.clear();
+    table.clear();
+    endpoints.clear();
+    used = 0;
+  }
+
+private:
+  static constexpr int emptySlot = -1;
+  static constexpr int deletedSlot = -2;
+
+  std::vector<line> lines;
+  std::vector<int> table;
+  size_t used = 0;
+  std::unordered_map<uint64_t, std::vector<int>> endpoints;
+
+  static uint64_t Vertex(const int x, const int y)
+  {
+    return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+  }
+
+  static bool Same(const line& a, const line& b)
+  {
+    return (a.x1 == b.x1 && a.y1 == b.y1 && a.x2 == b.x2 && a.y2 == b.y2) ||
+      (a.x1 == b.x2 && a.y1 == b.y2 && a.x2 == b.x1 && a.y2 == b.y1);
+  }
+
+  /**
+   * @brief Hashes the endpoint pair independent of the line's direction
+   */
+  static size_t Hash(const line& edge)
+  {
+    uint64_t a = Vertex(edge.x1, edge.y1);
+    uint64_t b = Vertex(edge.x2, edge.y2);
+    if (a > b)
+    {
+      std::swap(a, b);
+    }
+
+    uint64_t hash = a * 0x9e3779b97f4a7c15ull;
+    hash ^= b + 0x632be59bd9b4e019ull + (hash << 6) + (hash >> 2);
+    hash ^= hash >> 31;
+    hash *= 0xbf58476d1ce4e5b9ull;
+    hash ^= hash >> 29;
+    return (size_t)hash;
+  }
+
+  /**
+   * @brief Returns the table slot holding a line, or -1
+   */
+  long long Slot(const line& edge) const
+  {
+    if (table.empty())
+    {
+      return -1;
+    }
+
+    const size_t mask = table.size() - 1;
+    for (size_t slot = Hash(edge) & mask; table[slot] != emptySlot; slot = (slot + 1) & mask)
+    {
+      if (table[slot] != deletedSlot && Same(lines[table[slot]], edge))
+      {
+        return (long long)slot;
+      }
+    }
+
+    return -1;
+  }
+
+  int Find(const line& edge) const
+  {
+    const long long slot = Slot(edge);
+    return (slot == -1) ? -1 : table[slot];
+  }
+
+  void Claim(const line& edge, const int index)
+  {
+    const size_t mask = table.size() - 1;
+    size_t slot = Hash(edge) & mask;
+
+    while (table[slot] >= 0)
+    {
+      slot = (slot + 1) & mask;
+    }
+
+    if (table[slot] == emptySlot)
+    {
+      used++;
+    }
+
+    table[slot] = index;
+  }
+
+  void Rehash(const size_t minimum)
+  {
+    size_t capacity = 16;
+    while (capacity < minimum)
+    {
+      capacity *= 2;
+    }
+
+    table.assign(capacity, emptySlot);
+    used = 0;
+
+    for (int i = 0; i < (int)lines.size(); i++)
+    {
+      Claim(lines[i], i);
+    }
+  }
+
+  static void Replace(std::vector<int>& indices, const int from, const int to)
+  {
+    for (auto& index : indices)
+    {
+      if (index == from)
+      {
+        index = to;
+      }
+    }
+  }
+
+  void Unlink(const int x, const int y, const int index)
+  {
+    const auto found = endpoints.find(Vertex(x, y));
+    if (found == endpoints.end())
+    {
+      return;
+    }
+
+    std::vector<int>& indices = found->second;
+    indices.erase(std::remove(indices.begin(), indices.end(), index), indices.end());
+
+    if (indices.empty())
+    {
+      endpoints.erase(found);
+    }
+  }
+
+  void EraseAt(const int index)
+  {
+    const line removed = lines[index];
+    table[Slot(removed)] = deletedSlot;
+    Unlink(removed.x1, removed.y1, index);
+    Unlink(removed.x2, removed.y2, index);
+
+    // Fill the hole with the last line
+    const int last = (int)lines.size() - 1;
+    if (index != last)
+    {
+      const line moved = lines[last];
+      table[Slot(moved)] = index;
+      Replace(endpoints[Vertex(moved.x1, moved.y1)], last, index);
+      Replace(endpoints[Vertex(moved.x2, moved.y2)], last, index);
+      lines[index] = moved;
+    }
+
+    lines.pop_back();
+  }
+};
@@ -0,0 +1,230 @@
+#pragma once
+
+#include "olcPixelGameEngine.h"
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Runs an application without a window at a fixed time step and with scripted input
+ *
+ * Frames are stepped on the calling thread as fast as they can be drawn, so the same
+ * script always produces the same frames. Every event is applied right before the
+ * frame it is scheduled for, which means a press and a release need different frames
+ * to be seen as a click.
+ */
+class HeadlessDriver
+{
+public:
+  /**
+   * @param engine The application, olc_ConfigureHeadless() must have been called before Construct()
+   * @param elapsedTime The time every frame reports as having passed
+   */
+  explicit HeadlessDriver(olc::PixelGameEngine& engine, const float elapsedTime = 1.0f / 60.0f) : engine(engine), elapsedTime(elapsedTime)
+  {
+  }
+
+  void MoveMouse(const uint32_t frame, const olc::vi2d& position)
+  {
+    script.push_back({frame, MOUSE_MOVE, 0, position});
+  }
+
+  void PressMouse(const uint32_t frame, const int32_t button)
+  {
+    script.push_back({frame, MOUSE_BUTTON, button, {1, 0}});
+  }
+
+  void ReleaseMouse(const uint32_t frame, const int32_t button)
+  {
+    script.push_back({frame, MOUSE_BUTTON, button, {0, 0}});
+  }
+
+  /**
+   * @brief Presses and releases a mouse button at a position, taking two frames
+   */
+  void Click(const uint32_t frame, const olc::vi2d& position, const int32_t button = 0)
+  {
+    MoveMouse(frame, position);
+    PressMouse(frame, button);
+    ReleaseMouse(frame + 1, button);
+  }
+
+  void PressKey(const uint32_t frame, const olc::Key key)
+  {
+    script.push_back({frame, KEY, (int32_t)key, {1, 0}});
+  }
+
+  void ReleaseKey(const uint32_t frame, const olc::Key key)
+  {
+    script.push_back({frame, KEY, (int32_t)key, {0, 0}});
+  }
+
+  /**
+   * @brief Presses and releases a key, taking two frames
+   */
+  void Tap(const uint32_t frame, const olc::Key key)
+  {
+    PressKey(frame, key);
+    ReleaseKey(frame + 1, key);
+  }
+
+  /**
+   * @brief Creates the application and steps it
+   *
+   * @param frames How many frames to run at most
+   * @return uint32_t How many frames actually ran, the application may stop earlier
+   */
+  uint32_t Run(const uint32_t frames)
+  {
+    std::stable_sort(script.begin(), script.end(), [](const Event& a, const Event& b) { return a.frame < b.frame; });
+
+    const olc::vi2d windowSize = engine.GetWindowSize();
+    engine.olc_SetFixedElapsedTime(elapsedTime);
+    engine.olc_UpdateWindowSize(windowSize.x, windowSize.y);
+    engine.olc_UpdateKeyFocus(true);
+    engine.olc_UpdateMouseFocus(true);
+    engine.olc_PrepareEngine();
+    engine.olc_Reanimate();
+
+    if (!engine.OnUserCreate())
+    {
+      return 0;
+    }
+
+    uint32_t frame = 0;
+    size_t next = 0;
+    for (; frame < frames && engine.olc_IsRunning(); frame++)
+    {
+      for (; next < script.size() && script[next].frame <= frame; next++)
+      {
+        Apply(script[next]);
+      }
+
+      engine.olc_CoreUpdate();
+    }
+
+    engine.OnUserDestroy();
+    engine.olc_Terminate();
+    return frame;
+  }
+
+  /**
+   * @brief Writes the last frame as a binary PPM image
+   *
+   * Without a composited frame, the visible layers are blended back to front by their
+   * alpha, the same way the renderer composites them. Layer offsets, scales, tints and
+   * decals are not applied then.
+   *
+   * @param frame What the software renderer composited, if it was used
+   * @return bool Whether the file could be written
+   */
+  bool SaveFrame(const std::string& path, const olc::Sprite* frame = nullptr)
+  {
+    const std::vector<olc::LayerDesc>& layers = engine.GetLayers();
+    const olc::Sprite* front = layers[0].pDrawTarget.Sprite();
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+      return false;
+    }
+
+    if (frame != nullptr)
+    {
+      file << "P6\n" << frame->width << " " << frame->height << "\n255\n";
+
+      std::vector<uint8_t> row(frame->width * 3);
+      for (int32_t y = 0; y < frame->height; y++)
+      {
+        for (int32_t x = 0; x < frame->width; x++)
+        {
+          const olc::Pixel pixel = frame->pColData[y * frame->width + x];
+          row[x * 3 + 0] = pixel.r;
+          row[x * 3 + 1] = pixel.g;
+          row[x * 3 + 2] = pixel.b;
+        }
+
+        file.write((const char*)row.data(), row.size());
+      }
+
+      return (bool)file;
+    }
+
+    file << "P6\n" << front->width << " " << front->height << "\n255\n";
+
+    std::vector<uint8_t> row(front->width * 3);
+    for (int32_t y = 0; y < front->height; y++)
+    {
+      std::fill(row.begin(), row.end(), 0);
+
+      for (auto layer = layers.rbegin(); layer != layers.rend(); ++layer)
+      {
+        // The primary layer is always shown
+        const olc::Sprite* sprite = layer->pDrawTarget.Sprite();
+        if ((!layer->bShow && sprite != front) || y >= sprite->height)
+        {
+          continue;
+        }
+
+        for (int32_t x = 0; x < std::min(front->width, sprite->width); x++)
+        {
+          const olc::Pixel pixel = sprite->GetPixel(x, y);
+          row[x * 3 + 0] = (uint8_t)((pixel.r * pixel.a + row[x * 3 + 0] * (255 - pixel.a)) / 255);
+          row[x * 3 + 1] = (uint8_t)((pixel.g * pixel.a + row[x * 3 + 1] * (255 - pixel.a)) / 255);
+          row[x * 3 + 2] = (uint8_t)((pixel.b * pixel.a + row[x * 3 + 2] * (255 - pixel.a)) / 255);
+        }
+      }
+
+      file.write((const char*)row.data(), row.size());
+    }
+
+    return (bool)file;
+  }
+
+private:
+  enum EVENT
+  {
+    MOUSE_MOVE,
+    MOUSE_BUTTON,
+    KEY
+  };
+
+  /**
+   * @brief For buttons and keys, value.x holds whether they are pressed
+   */
+  struct Event
+  {
+    uint32_t frame;
+    EVENT type;
+    int32_t id;
+    olc::vi2d value;
+  };
+
+  olc::PixelGameEngine& engine;
+  float elapsedTime;
+  std::vector<Event> script;
+
+  void Apply(const Event& event)
+  {
+    switch (event.type)
+    {
+      case MOUSE_MOVE:
+      {
+        // Aim at the centre of the screen pixel so that scaling back never rounds down
+        const olc::vi2d pixelSize = engine.GetPixelSize();
+        const olc::vi2d window = event.value * pixelSize + pixelSize / 2;
+        engine.olc_UpdateMouse(window.x, window.y);
+        break;
+      }
+
+      case MOUSE_BUTTON:
+        engine.olc_UpdateMouseState(event.id, event.value.x != 0);
+        break;
+
+      case KEY:
+        engine.olc_UpdateKeyState(event.id, event.value.x != 0);
+        break;
+    }
+  }
+};
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "olcPixelGameEngine.h"
+#include "raycast.h"
+#include "visibility.h"
+#include <algorithm>
+#include <vector>
+
+/**
+ * @brief Whether two walls connect the same two points, in either direction
+ */
+inline bool SameSegment(const Segment& a, const Segment& b)
+{
+  return (a.start == b.start && a.end == b.end) || (a.start == b.end && a.end == b.start);
+}
+
+/**
+ * @brief The query interface light casting uses to find the closest wall along a ray
+ *
+ * Implementations are kept up to date one wall at a time as the user edits the map,
+ * and may be queried from several threads at once as long as nobody edits them.
+ */
+class OccluderIndex
+{
+public:
+  virtual ~OccluderIndex() = default;
+
+  /**
+   * @brief Adds a wall to the index
+   */
+  virtual void Insert(const Segment& segment) = 0;
+
+  /**
+   * @brief Removes a wall from the index, does nothing if it is not present
+   */
+  virtual void Remove(const Segment& segment) = 0;
+
+  /**
+   * @brief Removes all walls
+   */
+  virtual void Clear() = 0;
+
+  /**
+   * @brief Brings the index up to date after edits, called once before a batch of rays
+   */
+  virtual void Prepare()
+  {
+  }
+
+  /**
+   * @brief Finds the closest wall along a ray
+   *
+   * @param origin Start of the ray
+   * @param ray Direction of the ray, hits are reported in multiples of its length
+   * @param maxT Hits at or beyond this parameter are ignored
+   * @return RayHit The closest hit, or {maxT, -1}
+   */
+  virtual RayHit Raycast(const olc::vf2d& origin, const olc::vf2d& ray, const float maxT) const = 0;
+
+  /**
+   * @brief Collects walls that may overlap a box, possibly with a few more that do not
+   *
+   * @param boxMin Top left corner of the box
+   * @param boxMax Bottom right corner of the box
+   * @param found The walls are appended to this
+   */
+  virtual void Query(const olc::vf2d& boxMin, const olc::vf2d& boxMax, std::vector<Segment>& found) const = 0;
+};
+
+/**
+ * @brief Whether the bounding box of a wall overlaps a box
+ */
+inline bool SegmentOverlapsBox(const Segment& segment, const olc::vf2d& boxMin, const olc::vf2d& boxMax)
+{
+  return std::max(segment.start.x, segment.end.x) >= boxMin.x && std::min(segment.start.x, segment.end.x) <= boxMax.x &&
+    std::max(segment.start.y, segment.end.y) >= boxMin.y && std::min(segment.start.y, segment.end.y) <= boxMax.y;
+}
+
+/**
+ * @brief Tests every ray against every wall, using the batched SIMD kernel
+ */
+class BruteForceIndex : public OccluderIndex
+{
+public:
+  void Insert(const Segment& segment) override
+  {
+    segments.push_back(segment);
+    block.Add(segment);
+  }
+
+  void Remove(const Segment& segment) override
+  {
+    for (size_t i = 0; i < segments.size(); i++)
+    {
+      if (SameSegment(segments[i], segment))
+      {
+        // The last wall takes the place of the removed one in both copies
+        segments[i] = segments.back();
+        block.Set(i, segments[i]);
+        segments.pop_back();
+        block.RemoveLast();
+        return;
+      }
+    }
+  }
+
+  void Clear() override
+  {
+    segments.clear();
+    block.Clear();
+  }
+
+  RayHit Raycast(const olc::vf2d& origin, const olc::vf2d& ray, const float maxT) const override
+  {
+    return NearestHit(block, origin, ray, maxT);
+  }
+
+  void Query(const olc::vf2d& boxMin, const olc::vf2d& boxMax, std::vector<Segment>& found) const override
+  {
+    for (const auto& segment : segments)
+    {
+      if (SegmentOverlapsBox(segment, boxMin, boxMax))
+      {
+        found.push_back(segment);
+      }
+    }
+  }
+
+private:
+  std::vector<Segment> segments;
+  SegmentBlock block;
+};
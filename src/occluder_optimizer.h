@@ -0,0 +1,256 @@
+#pragma once
+
+#include "olcPixelGameEngine.h"
+#include "edge_store.h"
+#include "visibility.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <numeric>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Merges touching collinear lines into as few walls as possible
+ *
+ * Long walls are usually drawn as many short pieces, each of which would add endpoints
+ * (and therefore events or rays) to every light. Lines are grouped by the infinite line
+ * they lie on, and the pieces of a group are merged wherever they overlap or touch.
+ * Because lines sit on the integer grid, shared vertices are exactly equal and weld
+ * without any tolerance.
+ *
+ * Edits only re-merge the group of the changed line and report which walls disappeared
+ * and which appeared, so acceleration structures can be updated incrementally.
+ */
+class OccluderOptimizer
+{
+public:
+  /**
+   * @param scale Size of a grid cell in pixels, walls are produced in screen space
+   */
+  explicit OccluderOptimizer(const int scale = 1) : scale(scale)
+  {
+  }
+
+  /**
+   * @brief Adds a line and reports how the merged walls changed
+   *
+   * @param edge The line in grid coordinates
+   * @param removed Merged walls that no longer exist are appended to this
+   * @param added New merged walls are appended to this
+   */
+  void Insert(const line& edge, std::vector<Segment>& removed, std::vector<Segment>& added)
+  {
+    Key key;
+    if (!MakeKey(edge, key))
+    {
+      return;
+    }
+
+    Group& group = groups[key];
+    if (group.raw.empty())
+    {
+      group.base = {edge.x1, edge.y1};
+    }
+
+    group.raw.push_back(Interval(key, group, edge));
+    Merge(key, group, removed, added);
+  }
+
+  /**
+   * @brief Removes a line and reports how the merged walls changed
+   *
+   * @param edge The line in grid coordinates, as it was inserted (in either direction)
+   * @param removed Merged walls that no longer exist are appended to this
+   * @param added New merged walls are appended to this
+   */
+  void Remove(const line& edge, std::vector<Segment>& removed, std::vector<Segment>& added)
+  {
+    Key key;
+    if (!MakeKey(edge, key))
+    {
+      return;
+    }
+
+    const auto found = groups.find(key);
+    if (found == groups.end())
+    {
+      return;
+    }
+
+    Group& group = found->second;
+    const auto interval = std::find(group.raw.begin(), group.raw.end(), Interval(key, group, edge));
+    if (interval == group.raw.end())
+    {
+      return;
+    }
+
+    *interval = group.raw.back();
+    group.raw.pop_back();
+    Merge(key, group, removed, added);
+
+    if (group.raw.empty())
+    {
+      groups.erase(found);
+    }
+  }
+
+  void Clear()
+  {
+    groups.clear();
+    segments.clear();
+    dirty = false;
+  }
+
+  /**
+   * @brief All merged walls in screen space
+   */
+  const std::vector<Segment>& Segments()
+  {
+    if (dirty)
+    {
+      segments.clear();
+      for (const auto& group : groups)
+      {
+        segments.insert(segments.end(), group.second.merged.begin(), group.second.merged.end());
+      }
+      dirty = false;
+    }
+
+    return segments;
+  }
+
+private:
+  /**
+   * @brief Identifies the infinite line through a line: its reduced direction and offset
+   */
+  struct Key
+  {
+    int dx;
+    int dy;
+    long long offset;
+
+    bool operator==(const Key& other) const
+    {
+      return dx == other.dx && dy == other.dy && offset == other.offset;
+    }
+  };
+
+  struct KeyHash
+  {
+    size_t operator()(const Key& key) const
+    {
+      uint64_t hash = ((uint64_t)(uint32_t)key.dx << 32) | (uint32_t)key.dy;
+      hash ^= (uint64_t)key.offset + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+      return (size_t)hash;
+    }
+  };
+
+  /**
+   * @brief Lines in a group are stored as steps along the direction, relative to a base point
+   */
+  struct Group
+  {
+    olc::vi2d base;
+    std::vector<std::pair<long long, long long>> raw;
+    std::vector<Segment> merged;
+  };
+
+  int scale;
+  std::unordered_map<Key, Group, KeyHash> groups;
+  std::vector<Segment> segments;
+  bool dirty = false;
+
+  static bool MakeKey(const line& edge, Key& key)
+  {
+    int dx = edge.x2 - edge.x1;
+    int dy = edge.y2 - edge.y1;
+
+    // A line of zero length blocks nothing
+    if (dx == 0 && dy == 0)
+    {
+      return false;
+    }
+
+    const int divisor = std::gcd(std::abs(dx), std::abs(dy));
+    dx /= divisor;
+    dy /= divisor;
+
+    if (dx < 0 || (dx == 0 && dy < 0))
+    {
+      dx = -dx;
+      dy = -dy;
+    }
+
+    key = {dx, dy, (long long)dy * edge.x1 - (long long)dx * edge.y1};
+    return true;
+  }
+
+  static long long Step(const Key& key, const Group& group, const int x, const int y)
+  {
+    return ((long long)(x - group.base.x) * key.dx + (long long)(y - group.base.y) * key.dy) / ((long long)key.dx * key.dx + (long long)key.dy * key.dy);
+  }
+
+  static std::pair<long long, long long> Interval(const Key& key, const Group& group, const line& edge)
+  {
+    const long long a = Step(key, group, edge.x1, edge.y1);
+    const long long b = Step(key, group, edge.x2, edge.y2);
+    return {std::min(a, b), std::max(a, b)};
+  }
+
+  Segment ToSegment(const Key& key, const Group& group, const long long from, const long long to) const
+  {
+    return {
+      {(float)((group.base.x + from * key.dx) * scale), (float)((group.base.y + from * key.dy) * scale)},
+      {(float)((group.base.x + to * key.dx) * scale), (float)((group.base.y + to * key.dy) * scale)}
+    };
+  }
+
+  /**
+   * @brief Re-merges the lines of one group and reports the difference to the previous result
+   */
+  void Merge(const Key& key, Group& group, std::vector<Segment>& removed, std::vector<Segment>& added)
+  {
+    std::vector<std::pair<long long, long long>> intervals = group.raw;
+    std::sort(intervals.begin(), intervals.end());
+
+    std::vector<Segment> merged;
+    for (size_t i = 0; i < intervals.size();)
+    {
+      const long long from = intervals[i].first;
+      long long to = intervals[i].second;
+
+      // Overlapping and touching pieces become one wall
+      for (i++; i < intervals.size() && intervals[i].first <= to; i++)
+      {
+        to = std::max(to, intervals[i].second);
+      }
+
+      merged.push_back(ToSegment(key, group, from, to));
+    }
+
+    for (const auto& wall : group.merged)
+    {
+      if (std::find_if(merged.begin(), merged.end(), [&](const Segment& other) { return SameWall(wall, other); }) == merged.end())
+      {
+        removed.push_back(wall);
+      }
+    }
+
+    for (const auto& wall : merged)
+    {
+      if (std::find_if(group.merged.begin(), group.merged.end(), [&](const Segment& other) { return SameWall(wall, other); }) == group.merged.end())
+      {
+        added.push_back(wall);
+      }
+    }
+
+    group.merged.swap(merged);
+    dirty = true;
+  }
+
+  static bool SameWall(const Segment& a, const Segment& b)
+  {
+    return a.start == b.start && a.end == b.end;
+  }
+};
@@ -0,0 +1,295 @@
+#pragma once
+
+/**
+ * Scoped timers for the hot paths of a frame.
+ *
+ * Compile with -DSHADOW_PROFILE to record zones, without it every macro expands to
+ * nothing and no profiling code is left in the build. This header has to be included
+ * before olcPixelGameEngine.h so that the engine picks up OLC_PROFILE_ZONE as well.
+ *
+ *   PROFILE_ZONE("CastLight");  // Times the rest of the enclosing scope
+ *   PROFILE_FRAME();            // Marks the start of a new frame
+ */
+
+#if defined(SHADOW_PROFILE)
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A finished zone, times are in nanoseconds since the profiler was created
+ */
+struct ProfileRecord
+{
+  const char* name;
+  uint64_t start;
+  uint64_t end;
+  uint64_t frame;
+  uint32_t thread;
+  uint32_t depth;
+};
+
+/**
+ * @brief Timing of one zone averaged over several frames
+ */
+struct ProfileSummary
+{
+  const char* name;
+  uint32_t depth;
+  double milliseconds;
+  double calls;
+};
+
+/**
+ * @brief Collects zones from any thread into a fixed size ring buffer
+ *
+ * Writers claim a slot with a single atomic increment and never wait, so workers of the
+ * pool can record zones while the main thread reads. Every slot carries a sequence
+ * number which readers check before and after copying, records that were overwritten
+ * in the meantime are skipped. When the buffer is full the oldest records are lost.
+ */
+class Profiler
+{
+public:
+  static constexpr size_t capacity = 1 << 16;
+
+  static Profiler& Instance()
+  {
+    static Profiler profiler;
+    return profiler;
+  }
+
+  uint64_t Now() const
+  {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+  }
+
+  void NextFrame()
+  {
+    frame.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  uint64_t Frame() const
+  {
+    return frame.load(std::memory_order_relaxed);
+  }
+
+  void Record(const char* name, const uint64_t start, const uint64_t end, const uint32_t depth)
+  {
+    const uint64_t index = head.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = slots[index % capacity];
+
+    // Odd sequence numbers mark a slot that is being written. The fence keeps the writes to
+    // the record from moving ahead of the odd number, which a release store alone would allow
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.record = {name, start, end, Frame(), Thread(), depth};
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+  }
+
+  /**
+   * @brief Copies the records that are still in the buffer, oldest first
+   */
+  void Snapshot(std::vector<ProfileRecord>& records) const
+  {
+    records.clear();
+
+    const uint64_t last = head.load(std::memory_order_acquire);
+    const uint64_t first = last > capacity ? last - capacity : 0;
+
+    for (uint64_t index = first; index < last; index++)
+    {
+      ProfileRecord record;
+      if (Read(index, record))
+      {
+        records.push_back(record);
+      }
+    }
+  }
+
+  /**
+   * @brief Averages every zone over the last complete frames
+   *
+   * @param frames How many frames to average over
+   * @param summary Receives one entry per zone, ordered by the time the zone first started
+   */
+  void Summarize(const uint64_t frames, std::vector<ProfileSummary>& summary)
+  {
+    summary.clear();
+    scratch.clear();
+
+    const uint64_t current = Frame();
+    const uint64_t first = current > frames ? current - frames : 0;
+    if (current == first)
+    {
+      return;
+    }
+
+    // Walks back from the newest record until the frames of interest are behind
+    const uint64_t last = head.load(std::memory_order_acquire);
+    const uint64_t oldest = last > capacity ? last - capacity : 0;
+    for (uint64_t index = last; index > oldest; index--)
+    {
+      ProfileRecord record;
+      if (!Read(index - 1, record))
+      {
+        continue;
+      }
+
+      if (record.frame < first)
+      {
+        break;
+      }
+
+      // The current frame is still running, so it is left out
+      if (record.frame < current)
+      {
+        scratch.push_back(record);
+      }
+    }
+
+    std::sort(scratch.begin(), scratch.end(), [](const ProfileRecord& a, const ProfileRecord& b) { return a.start < b.start; });
+
+    for (const auto& record : scratch)
+    {
+      auto entry = std::find_if(summary.begin(), summary.end(), [&](const ProfileSummary& other) { return std::strcmp(other.name, record.name) == 0; });
+      if (entry == summary.end())
+      {
+        summary.push_back({record.name, record.depth, 0.0, 0.0});
+        entry = summary.end() - 1;
+      }
+
+      entry->milliseconds += (record.end - record.start) * 1e-6;
+      entry->calls += 1.0;
+    }
+
+    for (auto& entry : summary)
+    {
+      entry.milliseconds /= (double)(current - first);
+      entry.calls /= (double)(current - first);
+    }
+  }
+
+  /**
+   * @brief Writes the buffer in the Chrome trace event format, open it in chrome://tracing or Perfetto
+   *
+   * @return bool Whether the file could be written
+   */
+  bool ExportChromeTrace(const std::string& path)
+  {
+    Snapshot(scratch);
+
+    std::ofstream file(path);
+    if (!file)
+    {
+      return false;
+    }
+
+    file << "{\"traceEvents\":[\n";
+    for (size_t i = 0; i < scratch.size(); i++)
+    {
+      const ProfileRecord& record = scratch[i];
+      file << (i == 0 ? "" : ",\n")
+           << "{\"name\":\"" << record.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << record.thread
+           << ",\"ts\":" << record.start / 1000.0 << ",\"dur\":" << (record.end - record.start) / 1000.0
+           << ",\"args\":{\"frame\":" << record.frame << "}}";
+    }
+    file << "\n]}\n";
+
+    return (bool)file;
+  }
+
+  /**
+   * @brief Nesting depth of the zones currently open on the calling thread
+   */
+  static uint32_t& Depth()
+  {
+    thread_local uint32_t depth = 0;
+    return depth;
+  }
+
+private:
+  struct Slot
+  {
+    std::atomic<uint64_t> sequence{0};
+    ProfileRecord record;
+  };
+
+  std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+  std::unique_ptr<Slot[]> slots{new Slot[capacity]};
+  std::atomic<uint64_t> head{0};
+  std::atomic<uint64_t> frame{0};
+  std::atomic<uint32_t> threads{0};
+  std::vector<ProfileRecord> scratch;
+
+  /**
+   * @brief Copies a record, fails when its slot is being written or was reused since
+   */
+  bool Read(const uint64_t index, ProfileRecord& record) const
+  {
+    const Slot& slot = slots[index % capacity];
+
+    if (slot.sequence.load(std::memory_order_acquire) != 2 * index + 2)
+    {
+      return false;
+    }
+
+    record = slot.record;
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    return slot.sequence.load(std::memory_order_relaxed) == 2 * index + 2;
+  }
+
+  uint32_t Thread()
+  {
+    thread_local uint32_t thread = threads.fetch_add(1, std::memory_order_relaxed);
+    return thread;
+  }
+};
+
+/**
+ * @brief Records the time from its construction to the end of its scope
+ */
+class ProfileZone
+{
+public:
+  explicit ProfileZone(const char* name) : name(name), depth(Profiler::Depth()++), start(Profiler::Instance().Now())
+  {
+  }
+
+  ProfileZone(const ProfileZone&) = delete;
+  ProfileZone& operator=(const ProfileZone&) = delete;
+
+  ~ProfileZone()
+  {
+    Profiler::Instance().Record(name, start, Profiler::Instance().Now(), depth);
+    Profiler::Depth()--;
+  }
+
+private:
+  const char* name;
+  uint32_t depth;
+  uint64_t start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_FRAME() Profiler::Instance().NextFrame()
+
+#else
+
+#define PROFILE_ZONE(name)
+#define PROFILE_FRAME()
+
+#endif
+
+// Zones inside the engine itself
+#define OLC_PROFILE_ZONE(name) PROFILE_ZONE(name)
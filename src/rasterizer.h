@@ -0,0 +1,172 @@
+#pragma once
+
+#include "olcPixelGameEngine.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/**
+ * @brief Fills polygons scanline by scanline, handing whole spans to a writer
+ *
+ * Pixels are covered when their centre lies inside the polygon (even-odd rule), so
+ * polygons sharing an edge never both cover a pixel. Edges are bucketed by the scanline
+ * they start on and kept in an active list, which makes a polygon cost O(V log V) plus
+ * one call per span instead of one call per pixel.
+ */
+class PolygonRasterizer
+{
+public:
+  /**
+   * @brief Calls writer(y, x0, x1) for every span [x0, x1) on row y covered by the polygon
+   *
+   * @param polygon The polygon vertices in order
+   * @param clipMin Top left corner of the area spans are clipped to
+   * @param clipMax Bottom right corner (exclusive) of the area spans are clipped to
+   * @param writer Receives the spans
+   */
+  template<typename Writer>
+  void Rasterize(const std::vector<olc::vf2d>& polygon, const olc::vi2d& clipMin, const olc::vi2d& clipMax, Writer&& writer)
+  {
+    edges.clear();
+    active.clear();
+    crossings.clear();
+
+    if (polygon.size() < 3 || clipMin.x >= clipMax.x || clipMin.y >= clipMax.y)
+    {
+      return;
+    }
+
+    for (size_t i = 0; i < polygon.size(); i++)
+    {
+      olc::vf2d top = polygon[i];
+      olc::vf2d bottom = polygon[(i + 1) % polygon.size()];
+
+      if (top.y > bottom.y)
+      {
+        std::swap(top, bottom);
+      }
+
+      // The rows whose centres lie within [top.y, bottom.y)
+      const int first = std::max(clipMin.y, (int)std::ceil(top.y - 0.5f));
+      const int last = std::min(clipMax.y, (int)std::ceil(bottom.y - 0.5f));
+
+      // Horizontal edges and edges between two pixel centres cover no rows
+      if (first >= last)
+      {
+        continue;
+      }
+
+      const float slope = (bottom.x - top.x) / (bottom.y - top.y);
+      edges.push_back({first, last, top, slope});
+    }
+
+    if (edges.empty())
+    {
+      return;
+    }
+
+    std::sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) { return a.first < b.first; });
+
+    size_t next = 0;
+    for (int y = edges.front().first; y < clipMax.y && (next < edges.size() || !active.empty()); y++)
+    {
+      while (next < edges.size() && edges[next].first == y)
+      {
+        active.push_back(edges[next++]);
+      }
+
+      active.erase(std::remove_if(active.begin(), active.end(), [y](const Edge& edge) { return edge.last <= y; }), active.end());
+
+      crossings.clear();
+      // Evaluated directly rather than stepped, so long edges do not drift
+      for (const auto& edge : active)
+      {
+        crossings.push_back(edge.top.x + ((float)y + 0.5f - edge.top.y) * edge.slope);
+      }
+
+      std::sort(crossings.begin(), crossings.end());
+
+      for (size_t i = 0; i + 1 < crossings.size(); i += 2)
+      {
+        const int x0 = std::max(clipMin.x, (int)std::ceil(crossings[i] - 0.5f));
+        const int x1 = std::min(clipMax.x, (int)std::ceil(crossings[i + 1] - 0.5f));
+
+        if (x0 < x1)
+        {
+          writer(y, x0, x1);
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Fills a polygon with a solid colour, overwriting the pixels underneath
+   */
+  void Fill(olc::Sprite* target, const std::vector<olc::vf2d>& polygon, const olc::Pixel colour, const olc::vi2d& clipMin, const olc::vi2d& clipMax)
+  {
+    olc::Pixel* pixels = target->pColData.data();
+    const int width = target->width;
+    const olc::vi2d areaMin = clipMin.max({0, 0});
+    const olc::vi2d areaMax = clipMax.min({target->width, target->height});
+    MarkDirty(target, areaMin, areaMax);
+
+    Rasterize(polygon, areaMin, areaMax, [&](int y, int x0, int x1)
+    {
+      std::fill_n(pixels + (size_t)y * width + x0, x1 - x0, colour);
+    });
+  }
+
+  /**
+   * @brief Adds a colour onto the pixels of a polygon, saturating at white
+   */
+  void Add(olc::Sprite* target, const std::vector<olc::vf2d>& polygon, const olc::Pixel colour, const olc::vi2d& clipMin, const olc::vi2d& clipMax)
+  {
+    olc::Pixel* pixels = target->pColData.data();
+    const int width = target->width;
+    const olc::vi2d areaMin = clipMin.max({0, 0});
+    const olc::vi2d areaMax = clipMax.min({target->width, target->height});
+    MarkDirty(target, areaMin, areaMax);
+
+    Rasterize(polygon, areaMin, areaMax, [&](int y, int x0, int x1)
+    {
+      AddSpan(pixels + (size_t)y * width, x0, x1, colour);
+    });
+  }
+
+  /**
+   * @brief Adds a colour onto the pixels [x0, x1) of a row, saturating at white
+   */
+  static void AddSpan(olc::Pixel* row, const int x0, const int x1, const olc::Pixel colour)
+  {
+    for (int x = x0; x < x1; x++)
+    {
+      row[x].r = (uint8_t)std::min(255, row[x].r + colour.r);
+      row[x].g = (uint8_t)std::min(255, row[x].g + colour.g);
+      row[x].b = (uint8_t)std::min(255, row[x].b + colour.b);
+    }
+  }
+
+private:
+  /**
+   * @brief Marks the clip area for upload, which is cheaper than tracking every span
+   */
+  static void MarkDirty(olc::Sprite* target, const olc::vi2d& areaMin, const olc::vi2d& areaMax)
+  {
+    if (areaMin.x < areaMax.x && areaMin.y < areaMax.y)
+    {
+      target->MarkDirty(areaMin.x, areaMin.y, areaMax.x - areaMin.x, areaMax.y - areaMin.y);
+    }
+  }
+
+  struct Edge
+  {
+    int first;
+    int last;
+    olc::vf2d top;
+    float slope;
+  };
+
+  std::vector<Edge> edges;
+  std::vector<Edge> active;
+  std::vector<float> crossings;
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "olcPixelGameEngine.h"
+#include "occluder_index.h"
+#include "visibility.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/**
+ * @brief Computes visibility polygons by casting three rays at every wall endpoint
+ *
+ * This is the classic approach: a ray straight at each endpoint and one just either side
+ * of it, each resolved by an occluder index, then sorted by angle. It produces the same
+ * polygon as VisibilitySolver up to the tiny angular offsets.
+ */
+class RayVisibility
+{
+public:
+  /**
+   * @brief Computes the visibility polygon of a light
+   *
+   * @param light Position of the light, must lie strictly inside the bounds
+   * @param walls The walls that cast shadows, only their endpoints are used
+   * @param index The same walls, used to resolve the rays
+   * @param boundsMin Top left corner of the area the light is clipped to
+   * @param boundsMax Bottom right corner of the area the light is clipped to
+   * @param polygon Receives the polygon vertices in counter-clockwise angular order
+   */
+  void Compute(const olc::vf2d& light, const std::vector<Segment>& walls, const OccluderIndex& index, const olc::vf2d& boundsMin, const olc::vf2d& boundsMax, std::vector<olc::vf2d>& polygon)
+  {
+    polygon.clear();
+
+    if (light.x <= boundsMin.x || light.y <= boundsMin.y || light.x >= boundsMax.x || light.y >= boundsMax.y)
+    {
+      return;
+    }
+
+    endpoints.clear();
+    endpoints.insert(endpoints.end(), {boundsMin, {boundsMax.x, boundsMin.y}, boundsMax, {boundsMin.x, boundsMax.y}});
+
+    for (const auto& wall : walls)
+    {
+      endpoints.push_back(wall.start);
+      endpoints.push_back(wall.end);
+    }
+
+    // Walls drawn on a grid share most of their endpoints
+    std::sort(endpoints.begin(), endpoints.end(), [](const olc::vf2d& a, const olc::vf2d& b) { return a.x < b.x || (a.x == b.x && a.y < b.y); });
+    endpoints.erase(std::unique(endpoints.begin(), endpoints.end()), endpoints.end());
+
+    hits.clear();
+    for (const auto& endpoint : endpoints)
+    {
+      const float baseAngle = atan2f(endpoint.y - light.y, endpoint.x - light.x);
+
+      for (const float angle : {baseAngle - 0.0001f, baseAngle, baseAngle + 0.0001f})
+      {
+        const olc::vf2d ray = {cosf(angle), sinf(angle)};
+
+        // Rays that miss every wall end where they leave the bounds
+        const float reach = std::min(
+          (ray.x > 0.0f) ? (boundsMax.x - light.x) / ray.x : (ray.x < 0.0f) ? (boundsMin.x - light.x) / ray.x : INFINITY,
+          (ray.y > 0.0f) ? (boundsMax.y - light.y) / ray.y : (ray.y < 0.0f) ? (boundsMin.y - light.y) / ray.y : INFINITY);
+
+        const RayHit hit = index.Raycast(light, ray, reach);
+        hits.push_back({angle, light + ray * hit.t});
+      }
+    }
+
+    std::sort(hits.begin(), hits.end(), [](const AngledPoint& a, const AngledPoint& b) { return a.angle < b.angle; });
+
+    for (const auto& hit : hits)
+    {
+      polygon.push_back(hit.point);
+    }
+  }
+
+private:
+  struct AngledPoint
+  {
+    float angle;
+    olc::vf2d point;
+  };
+
+  std::vector<olc::vf2d> endpoints;
+  std::vector<AngledPoint> hits;
+};
@@ -0,0 +1,348 @@
+#pragma once
+
+#include "olcPixelGameEngine.h"
+#include "visibility.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define SHADOW_RAYCAST_X86
+  #include <immintrin.h>
+  #if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+    #define SHADOW_TARGET_AVX2
+  #else
+    #define SHADOW_TARGET_AVX2 __attribute__((target("avx2")))
+  #endif
+#endif
+
+/**
+ * @brief Walls stored as a structure of arrays so that one ray can be tested against several at once
+ *
+ * The arrays are padded with empty walls to a multiple of eight, which never report a hit,
+ * so the SIMD kernels can always load full registers.
+ */
+struct SegmentBlock
+{
+  static constexpr size_t lanes = 8;
+
+  std::vector<float> x1;
+  std::vector<float> y1;
+  std::vector<float> dx;
+  std::vector<float> dy;
+  size_t count = 0;
+
+  void Clear()
+  {
+    x1.clear();
+    y1.clear();
+    dx.clear();
+    dy.clear();
+    count = 0;
+  }
+
+  void Add(const Segment& segment)
+  {
+    // Overwrite the padding left behind by the previous call
+    x1.resize(count);
+    y1.resize(count);
+    dx.resize(count);
+    dy.resize(count);
+
+    x1.push_back(segment.start.x);
+    y1.push_back(segment.start.y);
+    dx.push_back(segment.end.x - segment.start.x);
+    dy.push_back(segment.end.y - segment.start.y);
+    count++;
+
+    const size_t padded = (count + lanes - 1) / lanes * lanes;
+    x1.resize(padded, 0.0f);
+    y1.resize(padded, 0.0f);
+    dx.resize(padded, 0.0f);
+    dy.resize(padded, 0.0f);
+  }
+
+  /**
+   * @brief Pads the walls added so far, so that the next one starts a fresh run of eight
+   */
+  void Pad()
+  {
+    count = Padded();
+  }
+
+  /**
+   * @brief Drops the last wall, its slot turns back into padding
+   */
+  void RemoveLast()
+  {
+    count--;
+    Set(count, {{0.0f, 0.0f}, {0.0f, 0.0f}});
+
+    const size_t padded = Padded(count);
+    x1.resize(padded);
+    y1.resize(padded);
+    dx.resize(padded);
+    dy.resize(padded);
+  }
+
+  /**
+   * @brief Replaces the wall stored in a slot
+   */
+  void Set(const size_t slot, const Segment& segment)
+  {
+    x1[slot] = segment.start.x;
+    y1[slot] = segment.start.y;
+    dx[slot] = segment.end.x - segment.start.x;
+    dy[slot] = segment.end.y - segment.start.y;
+  }
+
+  size_t Padded() const
+  {
+    return x1.size();
+  }
+
+  /**
+   * @brief How many slots a run of walls takes up once padded
+   */
+  static constexpr size_t Padded(const size_t walls)
+  {
+    return (walls + lanes - 1) / lanes * lanes;
+  }
+};
+
+/**
+ * @brief The closest wall along a ray, segment is -1 when nothing was hit
+ */
+struct RayHit
+{
+  float t;
+  int segment;
+};
+
+namespace RayKernel
+{
+  // Hits closer than this are the wall the ray starts on
+  constexpr float minimumT = 1e-4f;
+
+  /**
+   * @brief Tests a ray against a single wall with the same rules as the batched kernels
+   *
+   * @param t Receives the ray parameter of the hit
+   * @return bool Whether the wall is hit in front of the ray origin
+   */
+  inline bool Intersect(const Segment& segment, const olc::vf2d& origin, const olc::vf2d& ray, float& t)
+  {
+    const float dx = segment.end.x - segment.start.x;
+    const float dy = segment.end.y - segment.start.y;
+    const float qx = segment.start.x - origin.x;
+    const float qy = segment.start.y - origin.y;
+    const float inverse = 1.0f / (ray.x * dy - ray.y * dx);
+    const float u = (qx * ray.y - qy * ray.x) * inverse;
+    t = (qx * dy - qy * dx) * inverse;
+
+    return t > minimumT && u >= 0.0f && u <= 1.0f;
+  }
+
+  /**
+   * @brief Tests a ray against walls [first, last) one at a time
+   *
+   * Every kernel computes the ray parameter t and the wall parameter u with a single
+   * reciprocal of the shared denominator, so all of them agree on what counts as a hit.
+   * The batched kernels take the same range, first and last have to be multiples of eight.
+   */
+  inline RayHit NearestScalar(const SegmentBlock& block, const size_t first, const size_t last, const olc::vf2d& origin, const olc::vf2d& ray, RayHit best)
+  {
+    for (size_t i = first; i < last; i++)
+    {
+      const float qx = block.x1[i] - origin.x;
+      const float qy = block.y1[i] - origin.y;
+      const float inverse = 1.0f / (ray.x * block.dy[i] - ray.y * block.dx[i]);
+      const float t = (qx * block.dy[i] - qy * block.dx[i]) * inverse;
+      const float u = (qx * ray.y - qy * ray.x) * inverse;
+
+      if (t > minimumT && t < best.t && u >= 0.0f && u <= 1.0f)
+      {
+        best = {t, (int)i};
+      }
+    }
+
+    return best;
+  }
+
+#if defined(SHADOW_RAYCAST_X86)
+  inline RayHit NearestSSE2(const SegmentBlock& block, const size_t first, const size_t last, const olc::vf2d& origin, const olc::vf2d& ray, const RayHit best)
+  {
+    const __m128 ox = _mm_set1_ps(origin.x);
+    const __m128 oy = _mm_set1_ps(origin.y);
+    const __m128 rx = _mm_set1_ps(ray.x);
+    const __m128 ry = _mm_set1_ps(ray.y);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 minT = _mm_set1_ps(minimumT);
+    const __m128i step = _mm_set1_epi32(4);
+
+    __m128 bestT = _mm_set1_ps(best.t);
+    __m128i bestIndex = _mm_set1_epi32(-1);
+    __m128i index = _mm_add_epi32(_mm_set1_epi32((int)first), _mm_setr_epi32(0, 1, 2, 3));
+
+    for (size_t i = first; i < last; i += 4)
+    {
+      const __m128 qx = _mm_sub_ps(_mm_loadu_ps(&block.x1[i]), ox);
+      const __m128 qy = _mm_sub_ps(_mm_loadu_ps(&block.y1[i]), oy);
+      const __m128 dx = _mm_loadu_ps(&block.dx[i]);
+      const __m128 dy = _mm_loadu_ps(&block.dy[i]);
+
+      const __m128 inverse = _mm_div_ps(one, _mm_sub_ps(_mm_mul_ps(rx, dy), _mm_mul_ps(ry, dx)));
+      const __m128 t = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(qx, dy), _mm_mul_ps(qy, dx)), inverse);
+      const __m128 u = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(qx, ry), _mm_mul_ps(qy, rx)), inverse);
+
+      // NaN and infinity from parallel or padding walls fail every comparison
+      const __m128 hit = _mm_and_ps(
+        _mm_and_ps(_mm_cmpgt_ps(t, minT), _mm_cmplt_ps(t, bestT)),
+        _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmple_ps(u, one)));
+
+      bestT = _mm_or_ps(_mm_and_ps(hit, t), _mm_andnot_ps(hit, bestT));
+      const __m128i hitMask = _mm_castps_si128(hit);
+      bestIndex = _mm_or_si128(_mm_and_si128(hitMask, index), _mm_andnot_si128(hitMask, bestIndex));
+      index = _mm_add_epi32(index, step);
+    }
+
+    alignas(16) float lanesT[4];
+    alignas(16) int lanesIndex[4];
+    _mm_store_ps(lanesT, bestT);
+    _mm_store_si128((__m128i*)lanesIndex, bestIndex);
+
+    RayHit nearest = best;
+    for (int lane = 0; lane < 4; lane++)
+    {
+      if (lanesIndex[lane] != -1 && lanesT[lane] < nearest.t)
+      {
+        nearest = {lanesT[lane], lanesIndex[lane]};
+      }
+    }
+
+    return nearest;
+  }
+
+  SHADOW_TARGET_AVX2 inline RayHit NearestAVX2(const SegmentBlock& block, const size_t first, const size_t last, const olc::vf2d& origin, const olc::vf2d& ray, const RayHit best)
+  {
+    const __m256 ox = _mm256_set1_ps(origin.x);
+    const __m256 oy = _mm256_set1_ps(origin.y);
+    const __m256 rx = _mm256_set1_ps(ray.x);
+    const __m256 ry = _mm256_set1_ps(ray.y);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 minT = _mm256_set1_ps(minimumT);
+    const __m256i step = _mm256_set1_epi32(8);
+
+    __m256 bestT = _mm256_set1_ps(best.t);
+    __m256i bestIndex = _mm256_set1_epi32(-1);
+    __m256i index = _mm256_add_epi32(_mm256_set1_epi32((int)first), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+    for (size_t i = first; i < last; i += 8)
+    {
+      const __m256 qx = _mm256_sub_ps(_mm256_loadu_ps(&block.x1[i]), ox);
+      const __m256 qy = _mm256_sub_ps(_mm256_loadu_ps(&block.y1[i]), oy);
+      const __m256 dx = _mm256_loadu_ps(&block.dx[i]);
+      const __m256 dy = _mm256_loadu_ps(&block.dy[i]);
+
+      const __m256 inverse = _mm256_div_ps(one, _mm256_sub_ps(_mm256_mul_ps(rx, dy), _mm256_mul_ps(ry, dx)));
+      const __m256 t = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(qx, dy), _mm256_mul_ps(qy, dx)), inverse);
+      const __m256 u = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(qx, ry), _mm256_mul_ps(qy, rx)), inverse);
+
+      const __m256 hit = _mm256_and_ps(
+        _mm256_and_ps(_mm256_cmp_ps(t, minT, _CMP_GT_OQ), _mm256_cmp_ps(t, bestT, _CMP_LT_OQ)),
+        _mm256_and_ps(_mm256_cmp_ps(u, zero, _CMP_GE_OQ), _mm256_cmp_ps(u, one, _CMP_LE_OQ)));
+
+      bestT = _mm256_blendv_ps(bestT, t, hit);
+      bestIndex = _mm256_blendv_epi8(bestIndex, index, _mm256_castps_si256(hit));
+      index = _mm256_add_epi32(index, step);
+    }
+
+    alignas(32) float lanesT[8];
+    alignas(32) int lanesIndex[8];
+    _mm256_store_ps(lanesT, bestT);
+    _mm256_store_si256((__m256i*)lanesIndex, bestIndex);
+
+    RayHit nearest = best;
+    for (int lane = 0; lane < 8; lane++)
+    {
+      if (lanesIndex[lane] != -1 && lanesT[lane] < nearest.t)
+      {
+        nearest = {lanesT[lane], lanesIndex[lane]};
+      }
+    }
+
+    return nearest;
+  }
+#endif
+
+  using Kernel = RayHit (*)(const SegmentBlock&, size_t, size_t, const olc::vf2d&, const olc::vf2d&, RayHit);
+
+  /**
+   * @brief Picks the widest kernel the CPU supports
+   */
+  inline Kernel Select()
+  {
+#if defined(SHADOW_RAYCAST_X86)
+  #if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] >= 7)
+    {
+      __cpuidex(info, 7, 0);
+      const bool avx2 = (info[1] & (1 << 5)) != 0;
+      __cpuid(info, 1);
+      const bool osxsave = (info[2] & (1 << 27)) != 0;
+      if (avx2 && osxsave && (_xgetbv(0) & 6) == 6)
+      {
+        return NearestAVX2;
+      }
+    }
+  #else
+    if (__builtin_cpu_supports("avx2"))
+    {
+      return NearestAVX2;
+    }
+  #endif
+    return NearestSSE2;
+#else
+    return NearestScalar;
+#endif
+  }
+
+  inline Kernel Active()
+  {
+    static const Kernel kernel = Select();
+    return kernel;
+  }
+}
+
+/**
+ * @brief Finds the closest wall hit by a ray
+ *
+ * @param block The walls to test
+ * @param origin Start of the ray
+ * @param ray Direction of the ray, hits are reported in multiples of its length
+ * @param maxT Hits at or beyond this parameter are ignored
+ * @return RayHit The closest hit, or {maxT, -1}
+ */
+inline RayHit NearestHit(const SegmentBlock& block, const olc::vf2d& origin, const olc::vf2d& ray, const float maxT)
+{
+  return RayKernel::Active()(block, 0, block.Padded(), origin, ray, {maxT, -1});
+}
+
+/**
+ * @brief Finds the closest wall hit by a ray among the slots [first, last) of a block
+ *
+ * @param first First slot to test, a multiple of eight
+ * @param last End of the slots to test, a multiple of eight
+ * @param best The closest hit found so far, only closer walls replace it
+ * @return RayHit The closer of best and the closest hit in the range
+ */
+inline RayHit NearestHit(const SegmentBlock& block, const size_t first, const size_t last, const olc::vf2d& origin, const olc::vf2d& ray, const RayHit best)
+{
+  return RayKernel::Active()(block, first, last, origin, ray, best);
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief A fixed set of worker threads that run the iterations of a loop in parallel
+ *
+ * The calling thread takes part in every loop as worker 0, so a pool of size one simply
+ * runs everything inline. Worker indices are stable, which lets callers keep per-worker
+ * scratch data such as visibility solvers without locking.
+ */
+class ThreadPool
+{
+public:
+  /**
+   * @param threads Number of threads running jobs, including the calling thread
+   */
+  explicit ThreadPool(unsigned int threads = std::thread::hardware_concurrency())
+  {
+    threads = std::max(1u, threads);
+
+    for (unsigned int worker = 1; worker < threads; worker++)
+    {
+      workers.emplace_back([this, worker]() { Run(worker); });
+    }
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  ~ThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+
+    wake.notify_all();
+
+    for (auto& worker : workers)
+    {
+      worker.join();
+    }
+  }
+
+  /**
+   * @brief The number of threads that run jobs, including the calling thread
+   */
+  size_t Size() const
+  {
+    return workers.size() + 1;
+  }
+
+  /**
+   * @brief Calls function(index, worker) for every index in [0, count) and waits for all of them
+   *
+   * @param count Number of iterations
+   * @param function The loop body, called concurrently from different workers
+   */
+  void ParallelFor(const size_t count, const std::function<void(size_t, size_t)>& function)
+  {
+    if (count == 0)
+    {
+      return;
+    }
+
+    if (workers.empty() || count == 1)
+    {
+      for (size_t i = 0; i < count; i++)
+      {
+        function(i, 0);
+      }
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      job = &function;
+      jobCount = count;
+      next = 0;
+      busy = workers.size();
+      generation++;
+    }
+
+    wake.notify_all();
+    Drain(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this]() { return busy == 0; });
+    job = nullptr;
+  }
+
+private:
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable done;
+
+  const std::function<void(size_t, size_t)>* job = nullptr;
+  size_t jobCount = 0;
+  std::atomic<size_t> next{0};
+  size_t busy = 0;
+  size_t generation = 0;
+  bool stopping = false;
+
+  void Drain(const size_t worker)
+  {
+    for (size_t i = next.fetch_add(1); i < jobCount; i = next.fetch_add(1))
+    {
+      (*job)(i, worker);
+    }
+  }
+
+  void Run(const size_t worker)
+  {
+    size_t seen = 0;
+
+    while (true)
+    {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [&]() { return stopping || generation != seen; });
+
+        if (stopping)
+        {
+          return;
+        }
+
+        seen = generation;
+      }
+
+      Drain(worker);
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busy == 0)
+        {
+          done.notify_one();
+        }
+      }
+    }
+  }
+};
@@ -0,0 +1,571 @@
+#pragma once
+
+#include "olcPixelGameEngine.h"
+#include "rasterizer.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief A colour in the units of the light map, whose channels carry fractionBits more bits than a pixel
+ */
+struct LightValue
+{
+  static constexpr int fractionBits = 4;
+
+  uint16_t r = 0;
+  uint16_t g = 0;
+  uint16_t b = 0;
+
+  static LightValue FromPixel(const olc::Pixel colour)
+  {
+    return {(uint16_t)(colour.r << fractionBits), (uint16_t)(colour.g << fractionBits), (uint16_t)(colour.b << fractionBits)};
+  }
+};
+
+/**
+ * @brief Fills a light map in horizontal tiles that the workers of a pool rasterize in parallel
+ *
+ * Polygons are binned into every tile their bounding box overlaps. A tile is then filled
+ * by a single worker, so no two workers ever write the same pixel and no locking is needed.
+ * Tiles span the whole width, which suits the scanline rasterizer: clipping a polygon to a
+ * tile only drops the rows outside of it. Tiles are handed out one at a time, so workers
+ * that finish early pick up the remaining ones.
+ *
+ * Lights are added into a 16 bit per channel accumulation buffer of the tile, which stays
+ * in the cache of the worker, with saturating integer adds. Once all polygons of a tile are
+ * in, it is resolved into the draw target through a tone mapping table, so any number of
+ * overlapping lights costs one write per pixel.
+ *
+ * Lights can fade with the distance from their origin. The squared distance is stepped
+ * along each span, so no pixel takes a square root. Falloff curves that are a quadratic in
+ * the squared distance are evaluated in 16 bit fixed point eight pixels at a time, any
+ * other curve is looked up in an attenuation table.
+ */
+class TileRasterizer
+{
+public:
+  /**
+   * @param tileRows Height of a tile in pixels
+   */
+  explicit TileRasterizer(const int tileRows = 32) : tileRows(std::max(1, tileRows))
+  {
+    SetToneMap([](float light) { return light; });
+    SetFalloff(1024.0f, [](float distance) { return 1.0f - distance * distance; });
+  }
+
+  /**
+   * @brief Sets how light fades with the distance from its origin, for polygons binned with one
+   *
+   * The curve is sampled into an attenuation table and fitted with a quadratic in the
+   * squared distance. Curves the quadratic reproduces, like 1 - d * d or
+   * (1 - d * d) * (1 - d * d), are evaluated from it, which is cheaper than reading the
+   * table. Any other curve, like 1 - d, keeps using the table. Past the range the light
+   * keeps the value the curve has at the range, which should be 0.
+   *
+   * @param range Distance in pixels beyond which lights are dark
+   * @param curve Maps the distance as a fraction of the range to the share of the light that
+   * is left, in [0, 1]
+   */
+  void SetFalloff(const float range, const std::function<float(float)>& curve)
+  {
+    falloffScale = 1.0f / (range * range);
+
+    // Sampled evenly in the squared distance from the light up to the range, pixels use
+    // the nearest entry and the last one covers everything out of range
+    std::vector<double> remaining(falloffSamples + 1);
+    for (int i = 0; i <= falloffSamples; i++)
+    {
+      remaining[i] = std::clamp(curve(std::sqrt((float)i / (float)falloffSamples)), 0.0f, 1.0f);
+    }
+
+    falloffMap.resize(falloffSamples + 1);
+    for (int i = 0; i <= falloffSamples; i++)
+    {
+      falloffMap[i] = (uint16_t)std::lround(remaining[i] * 65535.0);
+    }
+
+    // Least squares over the same samples, the normal equations are small enough to
+    // solve by elimination
+    double normal[3][4] = {};
+    for (int i = 0; i <= falloffSamples; i++)
+    {
+      const double squared = (double)i / (double)falloffSamples;
+      const double powers[3] = {1.0, squared, squared * squared};
+
+      for (int row = 0; row < 3; row++)
+      {
+        for (int column = 0; column < 3; column++)
+        {
+          normal[row][column] += powers[row] * powers[column];
+        }
+        normal[row][3] += powers[row] * remaining[i];
+      }
+    }
+
+    for (int pivot = 0; pivot < 3; pivot++)
+    {
+      for (int row = pivot + 1; row < 3; row++)
+      {
+        const double factor = normal[row][pivot] / normal[pivot][pivot];
+        for (int column = pivot; column < 4; column++)
+        {
+          normal[row][column] -= factor * normal[pivot][column];
+        }
+      }
+    }
+
+    double coefficients[3];
+    for (int row = 2; row >= 0; row--)
+    {
+      double value = normal[row][3];
+      for (int column = row + 1; column < 3; column++)
+      {
+        value -= normal[row][column] * coefficients[column];
+      }
+      coefficients[row] = value / normal[row][row];
+    }
+
+    // Every partial sum of Horner's scheme stays below the sum of the magnitudes, which
+    // decides how many fraction bits the 16 bit coefficients can have
+    double bound = 1.0;
+    for (const double coefficient : coefficients)
+    {
+      bound += std::abs(coefficient);
+    }
+    falloffBits = std::clamp(15 - (int)std::ceil(std::log2(bound)), 1, 14);
+
+    for (int i = 0; i < 3; i++)
+    {
+      falloffCurve[i] = (int16_t)std::lround(coefficients[i] * (double)(1 << falloffBits));
+    }
+
+    // The quadratic only stands in for the curve where it matches every sample
+    falloffFitted = true;
+    for (int i = 0; i <= falloffSamples; i++)
+    {
+      const double squared = (double)i / (double)falloffSamples;
+      const double fitted = coefficients[0] + (coefficients[1] + coefficients[2] * squared) * squared;
+      falloffFitted = falloffFitted && std::abs(fitted - remaining[i]) <= falloffTolerance;
+    }
+  }
+
+  /**
+   * @brief Sets the curve light values are resolved with
+   *
+   * @param curve Maps the light on a channel, in pixel units from 0 up to 4096, to the
+   * value written into the draw target, which is clamped to [0, 255]
+   */
+  void SetToneMap(const std::function<float(float)>& curve)
+  {
+    toneMap.resize(65536);
+    for (size_t value = 0; value < toneMap.size(); value++)
+    {
+      const float mapped = curve((float)value / (float)(1 << LightValue::fractionBits));
+      toneMap[value] = (uint8_t)std::clamp(std::lround(mapped), 0l, 255l);
+    }
+  }
+
+  /**
+   * @brief Starts a new light map covering [areaMin, areaMax), dropping all binned polygons
+   */
+  void Begin(const olc::vi2d& areaMin, const olc::vi2d& areaMax)
+  {
+    this->areaMin = areaMin;
+    this->areaMax = areaMax.max(areaMin);
+
+    const size_t tiles = (size_t)((this->areaMax.y - areaMin.y + tileRows - 1) / tileRows);
+    bins.resize(tiles);
+    for (auto& bin : bins)
+    {
+      bin.clear();
+    }
+    items.clear();
+  }
+
+  /**
+   * @brief Adds a polygon to the tiles it overlaps, its light is accumulated in Render()
+   *
+   * @param polygon Has to stay alive and unchanged until Render() returns
+   * @param light Added onto the light under the polygon, saturating at the channel maximum
+   */
+  void Bin(const std::vector<olc::vf2d>& polygon, const LightValue light)
+  {
+    Bin(polygon, light, {0.0f, 0.0f}, false);
+  }
+
+  /**
+   * @brief Adds a polygon whose light fades with the distance from origin, see SetFalloff()
+   */
+  void Bin(const std::vector<olc::vf2d>& polygon, const LightValue light, const olc::vf2d& origin)
+  {
+    Bin(polygon, light, origin, true);
+  }
+
+  /**
+   * @brief Accumulates the binned polygons on top of the background and resolves every tile into the target
+   */
+  void Render(ThreadPool& pool, olc::Sprite* target, const olc::Pixel background)
+  {
+    const olc::vi2d clipMin = areaMin.max({0, 0});
+    const olc::vi2d clipMax = areaMax.min({target->width, target->height});
+    if (clipMin.x >= clipMax.x || clipMin.y >= clipMax.y)
+    {
+      return;
+    }
+
+    // Dirty tracking is not thread safe, the whole area is marked up front instead
+    target->MarkDirty(clipMin.x, clipMin.y, clipMax.x - clipMin.x, clipMax.y - clipMin.y);
+
+    rasterizers.resize(pool.Size());
+    accumulation.resize(pool.Size());
+    olc::Pixel* pixels = target->pColData.data();
+    const int width = target->width;
+    const int tileWidth = clipMax.x - clipMin.x;
+    const LightValue base = LightValue::FromPixel(background);
+
+    pool.ParallelFor(bins.size(), [&](size_t tile, size_t worker)
+    {
+      const olc::vi2d tileMin = {clipMin.x, std::max(clipMin.y, areaMin.y + (int)tile * tileRows)};
+      const olc::vi2d tileMax = {clipMax.x, std::min(clipMax.y, areaMin.y + ((int)tile + 1) * tileRows)};
+
+      // Four channels per pixel, the fourth one is padding that keeps pixels aligned for SIMD
+      std::vector<uint16_t>& light = accumulation[worker];
+      light.resize((size_t)tileRows * tileWidth * 4);
+
+      for (size_t i = 0; i < (size_t)(tileMax.y - tileMin.y) * tileWidth * 4; i += 4)
+      {
+        light[i] = base.r;
+        light[i + 1] = base.g;
+        light[i + 2] = base.b;
+        light[i + 3] = 0;
+      }
+
+      PolygonRasterizer& rasterizer = rasterizers[worker];
+      for (const uint32_t item : bins[tile])
+      {
+        const Item& added = items[item];
+
+        rasterizer.Rasterize(*added.polygon, tileMin, tileMax, [&](int y, int x0, int x1)
+        {
+          uint16_t* row = light.data() + (size_t)(y - tileMin.y) * tileWidth * 4;
+
+          if (added.falloff)
+          {
+            const olc::vf2d offset = olc::vf2d((float)x0 + 0.5f, (float)y + 0.5f) - added.origin;
+            if (falloffFitted)
+            {
+              AddFittedFalloffSpan(row, x0 - tileMin.x, x1 - tileMin.x, added.light, offset);
+            }
+            else
+            {
+              AddTableFalloffSpan(row, x0 - tileMin.x, x1 - tileMin.x, added.light, offset);
+            }
+          }
+          else
+          {
+            AddSpan(row, x0 - tileMin.x, x1 - tileMin.x, added.light);
+          }
+        });
+      }
+
+      for (int y = tileMin.y; y < tileMax.y; y++)
+      {
+        ResolveSpan(light.data() + (size_t)(y - tileMin.y) * tileWidth * 4, pixels + (size_t)y * width + tileMin.x, tileWidth, background.a);
+      }
+    });
+  }
+
+private:
+  struct Item
+  {
+    const std::vector<olc::vf2d>* polygon;
+    LightValue light;
+    olc::vf2d origin;
+    bool falloff;
+  };
+
+  // Entries of the attenuation table, which at 2 bytes each stays in the cache, and the
+  // points of the curve the quadratic is fitted to
+  static constexpr int falloffSamples = 4096;
+  // How far the quadratic may stray from the curve, half a step of an 8 bit channel
+  static constexpr double falloffTolerance = 1.0 / 512.0;
+  // The squared distance as a fraction of the squared range is stepped in float and
+  // put into the quadratic with 15 fraction bits
+  static constexpr float fractionOne = 32767.0f;
+
+  int tileRows;
+  olc::vi2d areaMin;
+  olc::vi2d areaMax;
+  std::vector<Item> items;
+  // Indices into items for every tile, top to bottom
+  std::vector<std::vector<uint32_t>> bins;
+  // One per worker of the pool, as they keep scratch memory between calls
+  std::vector<PolygonRasterizer> rasterizers;
+  std::vector<std::vector<uint16_t>> accumulation;
+  // Output value for every light value a channel can hold
+  std::vector<uint8_t> toneMap;
+  // Coefficients of the quadratic giving the share of the light left at a squared distance,
+  // lowest power first, in fixed point with falloffBits fraction bits
+  int16_t falloffCurve[3] = {};
+  int falloffBits = 13;
+  // Whether the quadratic matches the curve, otherwise the table is used
+  bool falloffFitted = false;
+  // Share of the light left at a squared distance, in 16 bit fixed point
+  std::vector<uint16_t> falloffMap;
+  // Turns a squared distance into a fraction of the squared range
+  float falloffScale = 0.0f;
+
+  /**
+   * @brief Files a polygon under every tile its rows fall into
+   */
+  void Bin(const std::vector<olc::vf2d>& polygon, const LightValue light, const olc::vf2d& origin, const bool falloff)
+  {
+    if (polygon.size() < 3 || bins.empty())
+    {
+      return;
+    }
+
+    float top = polygon.front().y;
+    float bottom = polygon.front().y;
+    for (const auto& point : polygon)
+    {
+      top = std::min(top, point.y);
+      bottom = std::max(bottom, point.y);
+    }
+
+    // The rows whose centres lie within [top, bottom), as the rasterizer covers them
+    const int first = std::max(areaMin.y, (int)std::ceil(top - 0.5f));
+    const int last = std::min(areaMax.y, (int)std::ceil(bottom - 0.5f));
+    if (first >= last)
+    {
+      return;
+    }
+
+    const uint32_t item = (uint32_t)items.size();
+    items.push_back({&polygon, light, origin, falloff});
+
+    for (int tile = (first - areaMin.y) / tileRows; tile <= (last - 1 - areaMin.y) / tileRows; tile++)
+    {
+      bins[tile].push_back(item);
+    }
+  }
+
+  /**
+   * @brief Adds light onto the pixels [x0, x1) of a row of the accumulation buffer, saturating every channel
+   */
+  static void AddSpan(uint16_t* row, const int x0, const int x1, const LightValue light)
+  {
+    uint16_t* channels = row + (size_t)x0 * 4;
+    int count = x1 - x0;
+
+#if defined(OLC_BLEND_SSE2) || defined(OLC_BLEND_AVX2)
+    const long long packed = (long long)((uint64_t)light.r | ((uint64_t)light.g << 16) | ((uint64_t)light.b << 32));
+#if defined(OLC_BLEND_AVX2)
+    const __m256i added = _mm256_set1_epi64x(packed);
+    for (; count >= 4; count -= 4, channels += 16)
+    {
+      const __m256i sum = _mm256_adds_epu16(_mm256_loadu_si256((const __m256i*)channels), added);
+      _mm256_storeu_si256((__m256i*)channels, sum);
+    }
+#endif
+    const __m128i addedPair = _mm_set1_epi64x(packed);
+    for (; count >= 2; count -= 2, channels += 8)
+    {
+      const __m128i sum = _mm_adds_epu16(_mm_loadu_si128((const __m128i*)channels), addedPair);
+      _mm_storeu_si128((__m128i*)channels, sum);
+    }
+#endif
+
+    for (; count > 0; count--, channels += 4)
+    {
+      channels[0] = (uint16_t)std::min(65535, channels[0] + light.r);
+      channels[1] = (uint16_t)std::min(65535, channels[1] + light.g);
+      channels[2] = (uint16_t)std::min(65535, channels[2] + light.b);
+    }
+  }
+
+  /**
+   * @brief Adds light that fades with distance onto the pixels [x0, x1) of a row of the accumulation buffer
+   *
+   * Evaluates the quadratic fitted to the falloff curve.
+   *
+   * @param offset Position of the centre of the first pixel relative to the origin of the light
+   */
+  void AddFittedFalloffSpan(uint16_t* row, const int x0, const int x1, const LightValue light, const olc::vf2d& offset) const
+  {
+    uint16_t* channels = row + (size_t)x0 * 4;
+    // The squared distance is kept in units of the fraction of the squared range
+    const float scale = falloffScale * fractionOne;
+    const float dy2 = offset.y * offset.y;
+    float dx = offset.x;
+    int count = x1 - x0;
+
+#if defined(OLC_BLEND_SSE2) || defined(OLC_BLEND_AVX2)
+    if (count >= 8)
+    {
+      const __m128i lightPair = _mm_set1_epi64x((long long)((uint64_t)light.r | ((uint64_t)light.g << 16) | ((uint64_t)light.b << 32)));
+      const __m128i c0 = _mm_set1_epi16(falloffCurve[0]);
+      const __m128i c1 = _mm_set1_epi16(falloffCurve[1]);
+      const __m128i c2 = _mm_set1_epi16(falloffCurve[2]);
+      const __m128i brightest = _mm_set1_epi16((int16_t)((1 << falloffBits) - 1));
+      const __m128i widen = _mm_cvtsi32_si128(16 - falloffBits);
+
+      // Squared distances of eight pixels, and how much they grow over the next eight. That
+      // growth rises by 2 * 8 * 8 every step, as the distance is a quadratic in x
+      const __m128 lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+      const __m128 dxLow = _mm_add_ps(_mm_set1_ps(dx), lanes);
+      const __m128 dxHigh = _mm_add_ps(dxLow, _mm_set1_ps(4.0f));
+      const __m128 scaled = _mm_set1_ps(scale);
+      __m128 d2Low = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(dxLow, dxLow), _mm_set1_ps(dy2)), scaled);
+      __m128 d2High = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(dxHigh, dxHigh), _mm_set1_ps(dy2)), scaled);
+      __m128 stepLow = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(dxLow, _mm_set1_ps(16.0f)), _mm_set1_ps(64.0f)), scaled);
+      __m128 stepHigh = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(dxHigh, _mm_set1_ps(16.0f)), _mm_set1_ps(64.0f)), scaled);
+      const __m128 rise = _mm_set1_ps(128.0f * scale);
+
+      for (; count >= 8; count -= 8, channels += 32, dx += 8.0f)
+      {
+        // Packing saturates, so everything past the range lands on its edge
+        const __m128i fraction = _mm_packs_epi32(_mm_cvtps_epi32(d2Low), _mm_cvtps_epi32(d2High));
+
+        // Horner's scheme, every product drops 16 bits of which 15 were the fraction
+        __m128i value = _mm_add_epi16(_mm_slli_epi16(_mm_mulhi_epi16(c2, fraction), 1), c1);
+        value = _mm_add_epi16(_mm_slli_epi16(_mm_mulhi_epi16(value, fraction), 1), c0);
+
+        // Spreads the share of every pixel over its four channels, widened to 16 fraction bits
+        const __m128i shares = _mm_sll_epi16(_mm_min_epi16(_mm_max_epi16(value, _mm_setzero_si128()), brightest), widen);
+        const __m128i sharesLow = _mm_unpacklo_epi16(shares, shares);
+        const __m128i sharesHigh = _mm_unpackhi_epi16(shares, shares);
+        const __m128i pixelShares[4] = {
+          _mm_unpacklo_epi32(sharesLow, sharesLow), _mm_unpackhi_epi32(sharesLow, sharesLow),
+          _mm_unpacklo_epi32(sharesHigh, sharesHigh), _mm_unpackhi_epi32(sharesHigh, sharesHigh)
+        };
+
+        for (int pair = 0; pair < 4; pair++)
+        {
+          __m128i* pixels = (__m128i*)(channels + pair * 8);
+          _mm_storeu_si128(pixels, _mm_adds_epu16(_mm_loadu_si128(pixels), _mm_mulhi_epu16(lightPair, pixelShares[pair])));
+        }
+
+        d2Low = _mm_add_ps(d2Low, stepLow);
+        d2High = _mm_add_ps(d2High, stepHigh);
+        stepLow = _mm_add_ps(stepLow, rise);
+        stepHigh = _mm_add_ps(stepHigh, rise);
+      }
+    }
+#endif
+
+    // The same fixed point steps as above, one pixel at a time
+    float d2 = dx * dx + dy2;
+    float step = 2.0f * dx + 1.0f;
+    for (; count > 0; count--, channels += 4)
+    {
+      const int32_t fraction = (int32_t)std::lround(std::min(d2 * scale, fractionOne));
+      int32_t value = (((falloffCurve[2] * fraction) >> 16) << 1) + falloffCurve[1];
+      value = (((value * fraction) >> 16) << 1) + falloffCurve[0];
+      const uint32_t share = (uint32_t)std::clamp(value, 0, (1 << falloffBits) - 1) << (16 - falloffBits);
+
+      channels[0] = (uint16_t)std::min(65535u, channels[0] + ((light.r * share) >> 16));
+      channels[1] = (uint16_t)std::min(65535u, channels[1] + ((light.g * share) >> 16));
+      channels[2] = (uint16_t)std::min(65535u, channels[2] + ((light.b * share) >> 16));
+
+      d2 += step;
+      step += 2.0f;
+    }
+  }
+
+  /**
+   * @brief Adds light that fades with distance onto the pixels [x0, x1) of a row of the accumulation buffer
+   *
+   * Looks up the falloff curve in the attenuation table, for curves the quadratic does not match.
+   *
+   * @param offset Position of the centre of the first pixel relative to the origin of the light
+   */
+  void AddTableFalloffSpan(uint16_t* row, const int x0, const int x1, const LightValue light, const olc::vf2d& offset) const
+  {
+    uint16_t* channels = row + (size_t)x0 * 4;
+    const uint16_t* map = falloffMap.data();
+    // The squared distance is kept in units of table entries
+    const float scale = falloffScale * (float)falloffSamples;
+    const float limit = (float)falloffSamples;
+    // Half an entry further out, so that truncating picks the nearest entry
+    const float dy2 = offset.y * offset.y + 0.5f / scale;
+    float dx = offset.x;
+    int count = x1 - x0;
+
+#if defined(OLC_BLEND_SSE2) || defined(OLC_BLEND_AVX2)
+    if (count >= 8)
+    {
+      const __m128i lightPair = _mm_set1_epi64x((long long)((uint64_t)light.r | ((uint64_t)light.g << 16) | ((uint64_t)light.b << 32)));
+      const __m128 scaled = _mm_set1_ps(scale);
+      const __m128 last = _mm_set1_ps(limit);
+
+      // Stepped like the squared distances of AddFittedFalloffSpan()
+      const __m128 lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+      const __m128 dxLow = _mm_add_ps(_mm_set1_ps(dx), lanes);
+      const __m128 dxHigh = _mm_add_ps(dxLow, _mm_set1_ps(4.0f));
+      __m128 d2Low = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(dxLow, dxLow), _mm_set1_ps(dy2)), scaled);
+      __m128 d2High = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(dxHigh, dxHigh), _mm_set1_ps(dy2)), scaled);
+      __m128 stepLow = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(dxLow, _mm_set1_ps(16.0f)), _mm_set1_ps(64.0f)), scaled);
+      __m128 stepHigh = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(dxHigh, _mm_set1_ps(16.0f)), _mm_set1_ps(64.0f)), scaled);
+      const __m128 rise = _mm_set1_ps(128.0f * scale);
+
+      alignas(16) int32_t index[8];
+      for (; count >= 8; count -= 8, channels += 32, dx += 8.0f)
+      {
+        _mm_store_si128((__m128i*)index, _mm_cvttps_epi32(_mm_min_ps(d2Low, last)));
+        _mm_store_si128((__m128i*)(index + 4), _mm_cvttps_epi32(_mm_min_ps(d2High, last)));
+
+        // Spreads the share of every pixel over its four channels
+        const __m128i shares = _mm_setr_epi16(map[index[0]], map[index[1]], map[index[2]], map[index[3]], map[index[4]], map[index[5]], map[index[6]], map[index[7]]);
+        const __m128i sharesLow = _mm_unpacklo_epi16(shares, shares);
+        const __m128i sharesHigh = _mm_unpackhi_epi16(shares, shares);
+        const __m128i pixelShares[4] = {
+          _mm_unpacklo_epi32(sharesLow, sharesLow), _mm_unpackhi_epi32(sharesLow, sharesLow),
+          _mm_unpacklo_epi32(sharesHigh, sharesHigh), _mm_unpackhi_epi32(sharesHigh, sharesHigh)
+        };
+
+        for (int pair = 0; pair < 4; pair++)
+        {
+          __m128i* pixels = (__m128i*)(channels + pair * 8);
+          _mm_storeu_si128(pixels, _mm_adds_epu16(_mm_loadu_si128(pixels), _mm_mulhi_epu16(lightPair, pixelShares[pair])));
+        }
+
+        d2Low = _mm_add_ps(d2Low, stepLow);
+        d2High = _mm_add_ps(d2High, stepHigh);
+        stepLow = _mm_add_ps(stepLow, rise);
+        stepHigh = _mm_add_ps(stepHigh, rise);
+      }
+    }
+#endif
+
+    float d2 = dx * dx + dy2;
+    float step = 2.0f * dx + 1.0f;
+    for (; count > 0; count--, channels += 4)
+    {
+      const uint32_t share = map[(int)std::min(d2 * scale, limit)];
+      channels[0] = (uint16_t)std::min(65535u, channels[0] + ((light.r * share) >> 16));
+      channels[1] = (uint16_t)std::min(65535u, channels[1] + ((light.g * share) >> 16));
+      channels[2] = (uint16_t)std::min(65535u, channels[2] + ((light.b * share) >> 16));
+
+      d2 += step;
+      step += 2.0f;
+    }
+  }
+
+  /**
+   * @brief Writes a row of the accumulation buffer into the target through the tone map
+   */
+  void ResolveSpan(const uint16_t* channels, olc::Pixel* pixels, const int count, const uint8_t alpha) const
+  {
+    const uint8_t* map = toneMap.data();
+
+    for (int x = 0; x < count; x++, channels += 4)
+    {
+      pixels[x] = olc::Pixel(map[channels[0]], map[channels[1]], map[channels[2]], alpha);
+    }
+  }
+};
@@ -0,0 +1,254 @@
+#pragma once
+
+#include "olcPixelGameEngine.h"
+#include "occluder_index.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+/**
+ * @brief Buckets walls into the cells of a uniform grid and walks rays through it cell by cell
+ *
+ * A ray only tests the walls stored in the cells it crosses (found with a DDA walk) and
+ * stops as soon as the closest hit lies inside the cell it is in. Walls are added to every
+ * cell they touch, including cells they merely border, so walls drawn along grid lines are
+ * found from either side.
+ */
+class UniformGrid : public OccluderIndex
+{
+public:
+  /**
+   * @brief Sets the area covered by the grid, removing all walls
+   *
+   * @param width Width of the covered area in pixels
+   * @param height Height of the covered area in pixels
+   * @param cellSize Edge length of a single cell in pixels
+   */
+  void Resize(const int width, const int height, const int cellSize)
+  {
+    size = (float)cellSize;
+    columns = std::max(1, (width + cellSize - 1) / cellSize);
+    rows = std::max(1, (height + cellSize - 1) / cellSize);
+    Clear();
+  }
+
+  void Insert(const Segment& segment) override
+  {
+    int slot;
+
+    if (freeSlots.empty())
+    {
+      slot = (int)slots.size();
+      slots.push_back(segment);
+    }
+    else
+    {
+      slot = freeSlots.back();
+      freeSlots.pop_back();
+      slots[slot] = segment;
+    }
+
+    ForEachCell(segment, [&](std::vector<int>& cell) { cell.push_back(slot); });
+  }
+
+  void Remove(const Segment& segment) override
+  {
+    int slot = -1;
+
+    // Any cell the wall touches knows its slot
+    ForEachCell(segment, [&](std::vector<int>& cell)
+    {
+      for (const int candidate : cell)
+      {
+        if (slot == -1 && SameSegment(slots[candidate], segment))
+        {
+          slot = candidate;
+        }
+      }
+    });
+
+    if (slot == -1)
+    {
+      return;
+    }
+
+    ForEachCell(slots[slot], [&](std::vector<int>& cell)
+    {
+      cell.erase(std::remove(cell.begin(), cell.end(), slot), cell.end());
+    });
+
+    freeSlots.push_back(slot);
+  }
+
+  void Clear() override
+  {
+    cells.assign((size_t)columns * rows, {});
+    slots.clear();
+    freeSlots.clear();
+  }
+
+  RayHit Raycast(const olc::vf2d& origin, const olc::vf2d& ray, const float maxT) const override
+  {
+    RayHit best = {maxT, -1};
+
+    // Clip the ray against the grid so that it starts in a valid cell
+    float enter = 0.0f;
+    float exit = maxT;
+    if (!ClipAxis(origin.x, ray.x, (float)columns * size, enter, exit) || !ClipAxis(origin.y, ray.y, (float)rows * size, enter, exit))
+    {
+      return best;
+    }
+
+    const olc::vf2d start = origin + ray * enter;
+    int column = std::clamp((int)std::floor(start.x / size), 0, columns - 1);
+    int row = std::clamp((int)std::floor(start.y / size), 0, rows - 1);
+
+    const int stepX = (ray.x > 0.0f) ? 1 : (ray.x < 0.0f) ? -1 : 0;
+    const int stepY = (ray.y > 0.0f) ? 1 : (ray.y < 0.0f) ? -1 : 0;
+    const float infinity = std::numeric_limits<float>::infinity();
+
+    const float deltaX = (stepX != 0) ? size / std::abs(ray.x) : infinity;
+    const float deltaY = (stepY != 0) ? size / std::abs(ray.y) : infinity;
+    float nextX = (stepX > 0) ? ((column + 1) * size - origin.x) / ray.x : (stepX < 0) ? (column * size - origin.x) / ray.x : infinity;
+    float nextY = (stepY > 0) ? ((row + 1) * size - origin.y) / ray.y : (stepY < 0) ? (row * size - origin.y) / ray.y : infinity;
+
+    while (true)
+    {
+      for (const int slot : cells[(size_t)row * columns + column])
+      {
+        float t;
+        if (RayKernel::Intersect(slots[slot], origin, ray, t) && t < best.t)
+        {
+          best = {t, slot};
+        }
+      }
+
+      // Whatever lies beyond this cell is further away than a hit inside it
+      const float leave = std::min(nextX, nextY);
+      if (leave >= best.t)
+      {
+        break;
+      }
+
+      if (nextX < nextY)
+      {
+        column += stepX;
+        nextX += deltaX;
+      }
+      else
+      {
+        row += stepY;
+        nextY += deltaY;
+      }
+
+      if (column < 0 || column >= columns || row < 0 || row >= rows)
+      {
+        break;
+      }
+    }
+
+    return best;
+  }
+
+  void Query(const olc::vf2d& boxMin, const olc::vf2d& boxMax, std::vector<Segment>& found) const override
+  {
+    const int left = std::clamp((int)std::floor(boxMin.x / size), 0, columns - 1);
+    const int right = std::clamp((int)std::floor(boxMax.x / size), 0, columns - 1);
+    const int top = std::clamp((int)std::floor(boxMin.y / size), 0, rows - 1);
+    const int bottom = std::clamp((int)std::floor(boxMax.y / size), 0, rows - 1);
+
+    // Walls spanning several cells are listed in each of them
+    std::vector<int> touched;
+    for (int row = top; row <= bottom; row++)
+    {
+      for (int column = left; column <= right; column++)
+      {
+        const std::vector<int>& cell = cells[(size_t)row * columns + column];
+        touched.insert(touched.end(), cell.begin(), cell.end());
+      }
+    }
+
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+
+    for (const int slot : touched)
+    {
+      found.push_back(slots[slot]);
+    }
+  }
+
+private:
+  float size = 1.0f;
+  int columns = 1;
+  int rows = 1;
+
+  std::vector<std::vector<int>> cells = {{}};
+  std::vector<Segment> slots;
+  std::vector<int> freeSlots;
+
+  /**
+   * @brief Narrows [enter, exit] to the part of the ray inside [0, extent] along one axis
+   */
+  static bool ClipAxis(const float origin, const float direction, const float extent, float& enter, float& exit)
+  {
+    if (direction == 0.0f)
+    {
+      return origin >= 0.0f && origin <= extent;
+    }
+
+    float near = (0.0f - origin) / direction;
+    float far = (extent - origin) / direction;
+    if (near > far)
+    {
+      std::swap(near, far);
+    }
+
+    enter = std::max(enter, near);
+    exit = std::min(exit, far);
+    return enter <= exit;
+  }
+
+  /**
+   * @brief Calls a function for every cell a wall touches, borders included
+   */
+  template<typename Function>
+  void ForEachCell(const Segment& segment, Function&& function)
+  {
+    const float epsilon = 1e-3f;
+    const int left = std::clamp((int)std::floor((std::min(segment.start.x, segment.end.x) - epsilon) / size), 0, columns - 1);
+    const int right = std::clamp((int)std::floor((std::max(segment.start.x, segment.end.x) + epsilon) / size), 0, columns - 1);
+    const int top = std::clamp((int)std::floor((std::min(segment.start.y, segment.end.y) - epsilon) / size), 0, rows - 1);
+    const int bottom = std::clamp((int)std::floor((std::max(segment.start.y, segment.end.y) + epsilon) / size), 0, rows - 1);
+
+    const olc::vf2d along = segment.end - segment.start;
+
+    for (int row = top; row <= bottom; row++)
+    {
+      for (int column = left; column <= right; column++)
+      {
+        // The wall touches the cell unless all four corners lie strictly on one side of it
+        const float x0 = column * size - epsilon;
+        const float y0 = row * size - epsilon;
+        const float x1 = (column + 1) * size + epsilon;
+        const float y1 = (row + 1) * size + epsilon;
+
+        int positive = 0;
+        int negative = 0;
+        for (const olc::vf2d& corner : {olc::vf2d(x0, y0), olc::vf2d(x1, y0), olc::vf2d(x0, y1), olc::vf2d(x1, y1)})
+        {
+          const float side = along.cross(corner - segment.start);
+          positive += side > 0.0f;
+          negative += side < 0.0f;
+        }
+
+        if (positive == 4 || negative == 4)
+        {
+          continue;
+        }
+
+        function(cells[(size_t)row * columns + column]);
+      }
+    }
+  }
+};
@@ -0,0 +1,836 @@
+#pragma once
+
+#include "olcPixelGameEngine.h"
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <vector>
+
+/**
+ * @brief A wall in screen space that blocks light
+ */
+struct Segment
+{
+  olc::vf2d start;
+  olc::vf2d end;
+};
+
+/**
+ * @brief A piece of a wall that no other piece crosses, kept in double precision so that
+ * the pieces of a split wall meet exactly
+ */
+struct WallPiece
+{
+  olc::vd2d start;
+  olc::vd2d end;
+};
+
+/**
+ * @brief Segments binned into a uniform grid of cells along the cells they pass through
+ */
+class SegmentGrid
+{
+public:
+  /**
+   * @brief Bins segments, get(i, start, end) has to return the end points of segment i
+   *
+   * @param count Number of segments
+   * @param areaMin Top left corner of the area covered by the grid, nothing may lie outside of it
+   * @param areaMax Bottom right corner of the area covered by the grid
+   * @param get Returns the end points of a segment
+   */
+  template<typename Get>
+  void Build(const size_t count, const olc::vd2d& areaMin, const olc::vd2d& areaMax, Get&& get)
+  {
+    // About one cell per segment
+    side = std::clamp((int)std::ceil(std::sqrt((double)count)), 1, 1024);
+    gridMin = areaMin;
+    cellSize = ((areaMax - areaMin) / (double)side).max({1e-3, 1e-3});
+    cellScale = {1.0 / cellSize.x, 1.0 / cellSize.y};
+
+    start.assign((size_t)side * side + 1, 0);
+    for (size_t i = 0; i < count; i++)
+    {
+      olc::vd2d a, b;
+      get(i, a, b);
+      ForEachCell(a, b, [&](int cell) { start[cell + 1]++; });
+    }
+
+    for (size_t cell = 1; cell < start.size(); cell++)
+    {
+      start[cell] += start[cell - 1];
+    }
+
+    items.resize(start.back());
+    next.assign(start.begin(), start.end() - 1);
+    for (size_t i = 0; i < count; i++)
+    {
+      olc::vd2d a, b;
+      get(i, a, b);
+      ForEachCell(a, b, [&](int cell) { items[next[cell]++] = (int)i; });
+    }
+  }
+
+  int Cells() const
+  {
+    return side * side;
+  }
+
+  /**
+   * @brief The cell a point lies in, points outside of the grid count to the closest cell
+   */
+  int Cell(const olc::vd2d& point) const
+  {
+    return Row(point.y) * side + Column(point.x);
+  }
+
+  const int* begin(const int cell) const
+  {
+    return items.data() + start[cell];
+  }
+
+  const int* end(const int cell) const
+  {
+    return items.data() + start[cell + 1];
+  }
+
+  /**
+   * @brief Calls function(item) for every segment binned into a cell overlapping the box, segments may repeat
+   */
+  template<typename Function>
+  void Query(const olc::vd2d& boxMin, const olc::vd2d& boxMax, Function&& function) const
+  {
+    const int column1 = Column(boxMax.x);
+    const int row1 = Row(boxMax.y);
+
+    for (int row = Row(boxMin.y); row <= row1; row++)
+    {
+      for (int column = Column(boxMin.x); column <= column1; column++)
+      {
+        const int cell = row * side + column;
+        for (int item = start[cell]; item < start[cell + 1]; item++)
+        {
+          function(items[item]);
+        }
+      }
+    }
+  }
+
+private:
+  olc::vd2d gridMin;
+  olc::vd2d cellSize;
+  olc::vd2d cellScale;
+  int side = 1;
+  // Cell c holds items[start[c]] up to items[start[c + 1]]
+  std::vector<int> start;
+  std::vector<int> items;
+  std::vector<int> next;
+
+  int Column(const double x) const
+  {
+    return std::clamp((int)std::floor((x - gridMin.x) * cellScale.x), 0, side - 1);
+  }
+
+  int Row(const double y) const
+  {
+    return std::clamp((int)std::floor((y - gridMin.y) * cellScale.y), 0, side - 1);
+  }
+
+  /**
+   * @brief Visits the cells a segment passes through, column by column
+   *
+   * Within every column the rows between the heights the segment enters and leaves at are
+   * visited, padded a little so that points on the segment never round into a cell that
+   * is left out. Long diagonal segments touch a line of cells instead of their whole box.
+   */
+  template<typename Function>
+  void ForEachCell(const olc::vd2d& a, const olc::vd2d& b, Function&& function) const
+  {
+    const olc::vd2d left = a.x <= b.x ? a : b;
+    const olc::vd2d right = a.x <= b.x ? b : a;
+    const double padding = 1e-6 * std::max(cellSize.x, cellSize.y);
+    const bool vertical = right.x - left.x <= 1e-12;
+    const double slope = vertical ? 0.0 : (right.y - left.y) / (right.x - left.x);
+
+    const int column0 = Column(left.x - padding);
+    const int column1 = Column(right.x + padding);
+
+    for (int column = column0; column <= column1; column++)
+    {
+      // The part of the segment within this column
+      const double x0 = std::max(left.x, gridMin.x + column * cellSize.x);
+      const double x1 = std::min(right.x, gridMin.x + (column + 1) * cellSize.x);
+      const bool whole = vertical || column0 == column1;
+      const double y0 = whole ? left.y : left.y + (x0 - left.x) * slope;
+      const double y1 = whole ? right.y : left.y + (x1 - left.x) * slope;
+
+      const int row1 = Row(std::max(y0, y1) + padding);
+      for (int row = Row(std::min(y0, y1) - padding); row <= row1; row++)
+      {
+        function(row * side + column);
+      }
+    }
+  }
+};
+
+/**
+ * @brief Cuts walls at every point where two of them cross
+ *
+ * Walls are binned into a grid along the cells they pass through and only walls sharing
+ * a cell are tested against each other. A crossing is only recorded by the cell it lies
+ * in, so pairs sharing several cells are not cut twice. With about as many cells as
+ * walls this takes close to O(E) plus the number of crossings.
+ *
+ * The grid is kept, so that a light can look up just the walls around it and the pieces
+ * of those walls. The result only depends on the walls, so it should be computed once
+ * per change to the scene and shared by every light. Splitting is not thread safe,
+ * reading the result from several threads is.
+ */
+class CrossingSplitter
+{
+public:
+  /**
+   * @brief Splits the walls together with the outline of the bounds, which closes every polygon
+   *
+   * @param walls The walls to split
+   * @param boundsMin Top left corner of the area lights are clipped to
+   * @param boundsMax Bottom right corner of the area lights are clipped to
+   */
+  void Split(const std::vector<Segment>& walls, const olc::vf2d& boundsMin, const olc::vf2d& boundsMax)
+  {
+    input.assign(walls.begin(), walls.end());
+    input.push_back({{boundsMin.x, boundsMin.y}, {boundsMax.x, boundsMin.y}});
+    input.push_back({{boundsMax.x, boundsMin.y}, {boundsMax.x, boundsMax.y}});
+    input.push_back({{boundsMax.x, boundsMax.y}, {boundsMin.x, boundsMax.y}});
+    input.push_back({{boundsMin.x, boundsMax.y}, {boundsMin.x, boundsMin.y}});
+
+    olc::vd2d areaMin = {boundsMin.x, boundsMin.y};
+    olc::vd2d areaMax = {boundsMax.x, boundsMax.y};
+    lines.resize(input.size());
+    for (size_t i = 0; i < input.size(); i++)
+    {
+      lines[i] = {{input[i].start.x, input[i].start.y}, {input[i].end.x, input[i].end.y}};
+      areaMin = areaMin.min(lines[i].start).min(lines[i].end);
+      areaMax = areaMax.max(lines[i].start).max(lines[i].end);
+    }
+
+    grid.Build(lines.size(), areaMin, areaMax, [&](size_t i, olc::vd2d& a, olc::vd2d& b)
+    {
+      a = lines[i].start;
+      b = lines[i].end;
+    });
+
+    cuts.clear();
+    for (int cell = 0; cell < grid.Cells(); cell++)
+    {
+      for (const int* m = grid.begin(cell); m != grid.end(cell); m++)
+      {
+        for (const int* n = m + 1; n != grid.end(cell); n++)
+        {
+          // Cells list their walls in order, so the lower index is always the first wall and
+          // every cell computes the same point
+          Intersect(*m, *n, cell);
+        }
+      }
+    }
+
+    // Cuts are bucketed by wall, which leaves only a few to sort along every wall
+    firstCut.assign(lines.size() + 1, 0);
+    for (const auto& cut : cuts)
+    {
+      firstCut[cut.first + 1]++;
+    }
+
+    for (size_t i = 1; i < firstCut.size(); i++)
+    {
+      firstCut[i] += firstCut[i - 1];
+    }
+
+    sortedCuts.resize(cuts.size());
+    nextCut.assign(firstCut.begin(), firstCut.end() - 1);
+    for (const auto& cut : cuts)
+    {
+      sortedCuts[nextCut[cut.first]++] = cut.second;
+    }
+
+    for (size_t i = 0; i < lines.size(); i++)
+    {
+      std::sort(sortedCuts.begin() + firstCut[i], sortedCuts.begin() + firstCut[i + 1]);
+    }
+  }
+
+  /**
+   * @brief Number of walls split, including the four sides of the bounds
+   */
+  size_t Walls() const
+  {
+    return input.size();
+  }
+
+  /**
+   * @brief Calls function(wall) for the walls that may overlap a box, walls may repeat
+   */
+  template<typename Function>
+  void Query(const olc::vd2d& boxMin, const olc::vd2d& boxMax, Function&& function) const
+  {
+    grid.Query(boxMin, boxMax, function);
+  }
+
+  /**
+   * @brief Calls function(piece) for the pieces of a wall between two fractions of its length
+   */
+  template<typename Function>
+  void ForEachPiece(const int wall, const double from, const double to, Function&& function) const
+  {
+    const olc::vd2d start = lines[wall].start;
+    const olc::vd2d along = lines[wall].end - start;
+    const auto first = sortedCuts.begin() + firstCut[wall];
+    const auto last = sortedCuts.begin() + firstCut[wall + 1];
+
+    // Pieces run between consecutive cuts, the first one that ends past the start of the range is found by search
+    auto cut = std::lower_bound(first, last, from);
+    double begin = cut == first ? 0.0 : *(cut - 1);
+    for (;; ++cut)
+    {
+      const double end = cut == last ? 1.0 : *cut;
+
+      // Walls crossed several times at the same point only need one cut
+      if (end > begin)
+      {
+        function(WallPiece{begin == 0.0 ? start : start + along * begin, end == 1.0 ? lines[wall].end : start + along * end});
+      }
+
+      if (cut == last || end >= to)
+      {
+        break;
+      }
+
+      begin = end;
+    }
+  }
+
+  /**
+   * @brief The wall as it was split, in double precision
+   */
+  const WallPiece& Wall(const int wall) const
+  {
+    return lines[wall];
+  }
+
+private:
+  std::vector<Segment> input;
+  std::vector<WallPiece> lines;
+  SegmentGrid grid;
+  std::vector<std::pair<int, double>> cuts;
+  // The cuts of wall i, by their fraction along it, are sortedCuts[firstCut[i]] up to sortedCuts[firstCut[i + 1]]
+  std::vector<int> firstCut;
+  std::vector<int> nextCut;
+  std::vector<double> sortedCuts;
+
+  static double Cross(const olc::vd2d& a, const olc::vd2d& b)
+  {
+    return a.x * b.y - a.y * b.x;
+  }
+
+  /**
+   * @brief Records where walls i and j cross, if they do and the crossing lies in this cell
+   */
+  void Intersect(const int i, const int j, const int cell)
+  {
+    const WallPiece& a = lines[i];
+    const WallPiece& b = lines[j];
+
+    if (std::max(a.start.x, a.end.x) < std::min(b.start.x, b.end.x) || std::max(b.start.x, b.end.x) < std::min(a.start.x, a.end.x) ||
+        std::max(a.start.y, a.end.y) < std::min(b.start.y, b.end.y) || std::max(b.start.y, b.end.y) < std::min(a.start.y, a.end.y))
+    {
+      return;
+    }
+
+    const olc::vd2d r = a.end - a.start;
+    const olc::vd2d s = b.end - b.start;
+    const olc::vd2d offset = b.start - a.start;
+    double denominator = Cross(r, s);
+    double along = Cross(offset, s);
+    double across = Cross(offset, r);
+
+    // Parallel walls never cross, overlapping collinear ones are handled by the ordering
+    if (std::abs(denominator) < 1e-9)
+    {
+      return;
+    }
+
+    if (denominator < 0.0)
+    {
+      denominator = -denominator;
+      along = -along;
+      across = -across;
+    }
+
+    // Only proper crossings matter, walls touching at an end point keep their order. The
+    // fractions are compared before dividing, most pairs sharing a cell never cross.
+    const double margin = 1e-9 * denominator;
+    if (along <= margin || along >= denominator - margin || across <= margin || across >= denominator - margin)
+    {
+      return;
+    }
+
+    const double t = along / denominator;
+    if (grid.Cell(a.start + r * t) == cell)
+    {
+      cuts.push_back({i, t});
+      cuts.push_back({j, across / denominator});
+    }
+  }
+};
+
+/**
+ * @brief Computes the polygon lit by a point light using an angular sweep
+ *
+ * Every wall endpoint becomes an event sorted by its angle around the light. The
+ * events are swept once while an ordered set keeps the walls under the current ray
+ * sorted by distance, so the closest wall is always the first element and the
+ * polygon only gains vertices where that closest wall changes. This is O(E log E)
+ * per light instead of testing every ray against every wall.
+ *
+ * The scratch buffers are kept between calls, so a solver should be reused
+ * rather than constructed every frame. A single solver is not thread safe.
+ */
+class VisibilitySolver
+{
+public:
+  VisibilitySolver() : active(CloserAlongRay{this})
+  {
+  }
+
+  VisibilitySolver(const VisibilitySolver&) = delete;
+  VisibilitySolver& operator=(const VisibilitySolver&) = delete;
+
+  /**
+   * @brief Computes the visibility polygon of a light
+   *
+   * Splits the walls first, which is the costly part with many walls. Prefer splitting
+   * once with a CrossingSplitter and sharing the pieces between lights.
+   *
+   * @param light Position of the light, must lie strictly inside the bounds
+   * @param walls The walls that cast shadows, crossing walls are allowed
+   * @param boundsMin Top left corner of the area the light is clipped to
+   * @param boundsMax Bottom right corner of the area the light is clipped to
+   * @param polygon Receives the polygon vertices in counter-clockwise angular order
+   */
+  void Compute(const olc::vf2d& light, const std::vector<Segment>& walls, const olc::vf2d& boundsMin, const olc::vf2d& boundsMax, std::vector<olc::vf2d>& polygon)
+  {
+    polygon.clear();
+
+    if (!Inside(light, boundsMin, boundsMax))
+    {
+      return;
+    }
+
+    // The ordered set relies on walls never swapping places, so crossings (including
+    // walls that poke out of the bounds) are split first
+    splitter.Split(walls, boundsMin, boundsMax);
+    Compute(light, splitter, boundsMin, boundsMax, polygon);
+  }
+
+  /**
+   * @brief Computes the visibility polygon of a light from walls that have already been split
+   *
+   * Only the pieces within a box around the light are swept, closed off by the box. When
+   * the polygon reaches the box it may be cut short, so the box grows and the sweep runs
+   * again, until the box covers the bounds. Lights boxed in by nearby walls never look at
+   * the rest of the scene.
+   *
+   * @param light Position of the light, must lie strictly inside the bounds
+   * @param split Walls and bounds as split by CrossingSplitter::Split()
+   * @param boundsMin Top left corner of the area the walls were split with
+   * @param boundsMax Bottom right corner of the area the walls were split with
+   * @param polygon Receives the polygon vertices in counter-clockwise angular order
+   */
+  void Compute(const olc::vf2d& light, const CrossingSplitter& split, const olc::vf2d& boundsMin, const olc::vf2d& boundsMax, std::vector<olc::vf2d>& polygon)
+  {
+    polygon.clear();
+
+    if (!Inside(light, boundsMin, boundsMax))
+    {
+      return;
+    }
+
+    origin = {light.x, light.y};
+    const olc::vd2d areaMin = {boundsMin.x, boundsMin.y};
+    const olc::vd2d areaMax = {boundsMax.x, boundsMax.y};
+
+    if (seen.size() != split.Walls())
+    {
+      seen.assign(split.Walls(), 0);
+      stamp = 0;
+    }
+
+    for (double reach = firstReach;; reach *= 4.0)
+    {
+      boxMin = (origin - olc::vd2d{reach, reach}).max(areaMin);
+      boxMax = (origin + olc::vd2d{reach, reach}).min(areaMax);
+      // Sides of the box that lie on the bounds are real, the bounds pieces close them
+      clipLeft = boxMin.x > areaMin.x;
+      clipTop = boxMin.y > areaMin.y;
+      clipRight = boxMax.x < areaMax.x;
+      clipBottom = boxMax.y < areaMax.y;
+
+      edges.clear();
+      events.clear();
+
+      if (++stamp == 0)
+      {
+        std::fill(seen.begin(), seen.end(), 0);
+        stamp = 1;
+      }
+
+      split.Query(boxMin, boxMax, [&](const int wall)
+      {
+        double enter, leave;
+        if (seen[wall] != stamp && Clip(split.Wall(wall), enter, leave))
+        {
+          split.ForEachPiece(wall, enter, leave, [&](const WallPiece& piece) { AddClipped(piece); });
+        }
+        seen[wall] = stamp;
+      });
+
+      if (clipTop) AddEdge({boxMin.x, boxMin.y}, {boxMax.x, boxMin.y});
+      if (clipRight) AddEdge({boxMax.x, boxMin.y}, {boxMax.x, boxMax.y});
+      if (clipBottom) AddEdge({boxMax.x, boxMax.y}, {boxMin.x, boxMax.y});
+      if (clipLeft) AddEdge({boxMin.x, boxMax.y}, {boxMin.x, boxMin.y});
+
+      Sweep(polygon);
+
+      if (!(clipLeft || clipTop || clipRight || clipBottom) || !ReachesBox(polygon))
+      {
+        return;
+      }
+    }
+  }
+
+private:
+  /**
+   * @brief A wall oriented so that it runs counter-clockwise around the light
+   */
+  struct Edge
+  {
+    olc::vd2d start;
+    olc::vd2d end;
+    bool wrapped;
+  };
+
+  struct Event
+  {
+    double angle;
+    olc::vd2d point;
+    int edge;
+    bool begin;
+  };
+
+  /**
+   * @brief Orders walls by their distance along the current sweep direction
+   */
+  struct CloserAlongRay
+  {
+    const VisibilitySolver* solver;
+
+    bool operator()(const int a, const int b) const
+    {
+      const double distanceA = solver->Distance(a, solver->direction);
+      const double distanceB = solver->Distance(b, solver->direction);
+
+      // Overlapping collinear walls are equally close, the index keeps them distinct
+      if (distanceA != distanceB)
+      {
+        return distanceA < distanceB;
+      }
+
+      return a < b;
+    }
+  };
+
+  static constexpr double angleEpsilon = 1e-9;
+  static constexpr double crossEpsilon = 1e-9;
+  // Half the size of the first box swept around a light, in pixels
+  static constexpr double firstReach = 32.0;
+
+  olc::vd2d origin;
+  olc::vd2d direction;
+  olc::vd2d boxMin;
+  olc::vd2d boxMax;
+  bool clipLeft = false;
+  bool clipTop = false;
+  bool clipRight = false;
+  bool clipBottom = false;
+
+  CrossingSplitter splitter;
+  std::vector<uint32_t> seen;
+  uint32_t stamp = 0;
+  std::vector<Edge> edges;
+  std::vector<Event> events;
+  std::set<int, CloserAlongRay> active;
+  std::vector<std::set<int, CloserAlongRay>::iterator> handles;
+  std::vector<bool> inSet;
+
+  static double Cross(const olc::vd2d& a, const olc::vd2d& b)
+  {
+    return a.x * b.y - a.y * b.x;
+  }
+
+  static olc::vd2d Direction(const double angle)
+  {
+    return {std::cos(angle), std::sin(angle)};
+  }
+
+  static double Angle(const olc::vd2d& v)
+  {
+    // Adding 0.0 turns -0.0 into 0.0 so that atan2 never returns -pi
+    return std::atan2(v.y + 0.0, v.x);
+  }
+
+  static bool Same(const olc::vf2d& a, const olc::vf2d& b)
+  {
+    return std::abs(a.x - b.x) < 1e-3f && std::abs(a.y - b.y) < 1e-3f;
+  }
+
+  static bool Inside(const olc::vf2d& light, const olc::vf2d& boundsMin, const olc::vf2d& boundsMax)
+  {
+    return light.x > boundsMin.x && light.y > boundsMin.y && light.x < boundsMax.x && light.y < boundsMax.y;
+  }
+
+  /**
+   * @brief Sweeps the events of the edges added so far
+   */
+  void Sweep(std::vector<olc::vf2d>& polygon)
+  {
+    polygon.clear();
+    handles.clear();
+    active.clear();
+
+    if (events.empty())
+    {
+      return;
+    }
+
+    std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) { return a.angle < b.angle; });
+    handles.resize(edges.size());
+    inSet.assign(edges.size(), false);
+
+    // Walls that straddle the angle -pi/pi are already under the ray when the sweep starts
+    const double firstAngle = events.front().angle;
+    const double lastAngle = events.back().angle;
+    direction = Direction(0.5 * (lastAngle - 2.0 * M_PI + firstAngle));
+    for (int i = 0; i < (int)edges.size(); i++)
+    {
+      if (edges[i].wrapped)
+      {
+        Insert(i);
+      }
+    }
+
+    size_t group = 0;
+    while (group < events.size())
+    {
+      // All events at (almost) the same angle are handled together
+      size_t groupEnd = group + 1;
+      while (groupEnd < events.size() && events[groupEnd].angle - events[groupEnd - 1].angle < angleEpsilon)
+      {
+        groupEnd++;
+      }
+
+      const int nearestBefore = active.empty() ? -1 : *active.begin();
+
+      for (size_t i = group; i < groupEnd; i++)
+      {
+        if (!events[i].begin)
+        {
+          Remove(events[i].edge);
+        }
+      }
+
+      // Insertions are ordered along a ray through the middle of the upcoming interval,
+      // where walls that merely touch at this angle are already apart
+      const double nextAngle = groupEnd < events.size() ? events[groupEnd].angle : firstAngle + 2.0 * M_PI;
+      direction = Direction(0.5 * (events[group].angle + nextAngle));
+
+      for (size_t i = group; i < groupEnd; i++)
+      {
+        if (events[i].begin)
+        {
+          Insert(events[i].edge);
+        }
+      }
+
+      const int nearestAfter = active.empty() ? -1 : *active.begin();
+
+      if (nearestBefore != nearestAfter)
+      {
+        const olc::vd2d ray = events[group].point - origin;
+
+        if (nearestBefore != -1)
+        {
+          Emit(Hit(nearestBefore, ray), polygon);
+        }
+
+        if (nearestAfter != -1)
+        {
+          Emit(Hit(nearestAfter, ray), polygon);
+        }
+      }
+
+      group = groupEnd;
+    }
+
+    if (polygon.size() > 1 && Same(polygon.front(), polygon.back()))
+    {
+      polygon.pop_back();
+    }
+  }
+
+  /**
+   * @brief Finds the fractions along a segment at which it enters and leaves the box
+   */
+  bool Clip(const WallPiece& segment, double& enter, double& leave) const
+  {
+    const olc::vd2d along = segment.end - segment.start;
+    enter = 0.0;
+    leave = 1.0;
+
+    // Liang-Barsky, clips the range against the four sides in turn
+    const auto clip = [&](const double denominator, const double numerator)
+    {
+      if (denominator == 0.0)
+      {
+        return numerator >= 0.0;
+      }
+
+      const double t = numerator / denominator;
+      if (denominator < 0.0)
+      {
+        enter = std::max(enter, t);
+      }
+      else
+      {
+        leave = std::min(leave, t);
+      }
+
+      return enter <= leave;
+    };
+
+    return clip(-along.x, segment.start.x - boxMin.x) && clip(along.x, boxMax.x - segment.start.x) &&
+           clip(-along.y, segment.start.y - boxMin.y) && clip(along.y, boxMax.y - segment.start.y);
+  }
+
+  /**
+   * @brief Adds the part of a piece that lies within the box
+   */
+  void AddClipped(const WallPiece& piece)
+  {
+    double enter, leave;
+    if (Clip(piece, enter, leave))
+    {
+      // Ends inside the box are kept exactly, so that pieces of one wall still meet
+      const olc::vd2d along = piece.end - piece.start;
+      const olc::vd2d start = enter > 0.0 ? piece.start + along * enter : piece.start;
+      const olc::vd2d end = leave < 1.0 ? piece.start + along * leave : piece.end;
+      AddEdge(start, end);
+    }
+  }
+
+  /**
+   * @brief Whether the polygon touches a side of the box that does not lie on the bounds
+   */
+  bool ReachesBox(const std::vector<olc::vf2d>& polygon) const
+  {
+    const double tolerance = 1e-2;
+
+    for (const auto& p : polygon)
+    {
+      if ((clipLeft && p.x <= boxMin.x + tolerance) || (clipRight && p.x >= boxMax.x - tolerance) ||
+          (clipTop && p.y <= boxMin.y + tolerance) || (clipBottom && p.y >= boxMax.y - tolerance))
+      {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  /**
+   * @brief Adds a wall and its two angular events, walls in line with the light are dropped
+   */
+  void AddEdge(olc::vd2d start, olc::vd2d end)
+  {
+    const double cross = Cross(start - origin, end - origin);
+
+    // A wall seen edge-on (or passing through the light) blocks nothing
+    if (std::abs(cross) < crossEpsilon)
+    {
+      return;
+    }
+
+    if (cross < 0)
+    {
+      std::swap(start, end);
+    }
+
+    const double startAngle = Angle(start - origin);
+    const double endAngle = Angle(end - origin);
+    const bool wrapped = startAngle > endAngle;
+
+    // Slivers thinner than the event grouping would begin and end in the same group
+    const double extent = wrapped ? endAngle - startAngle + 2.0 * M_PI : endAngle - startAngle;
+    if (extent < 1e3 * angleEpsilon)
+    {
+      return;
+    }
+
+    const int index = (int)edges.size();
+    edges.push_back({start, end, wrapped});
+    events.push_back({startAngle, start, index, true});
+    events.push_back({endAngle, end, index, false});
+  }
+
+  void Insert(const int edge)
+  {
+    if (!inSet[edge])
+    {
+      handles[edge] = active.insert(edge).first;
+      inSet[edge] = true;
+    }
+  }
+
+  void Remove(const int edge)
+  {
+    if (inSet[edge])
+    {
+      active.erase(handles[edge]);
+      inSet[edge] = false;
+    }
+  }
+
+  /**
+   * @brief Distance from the light to an edge along a ray, in units of the ray length
+   */
+  double Distance(const int edge, const olc::vd2d& ray) const
+  {
+    const Edge& e = edges[edge];
+    const olc::vd2d along = e.end - e.start;
+    return Cross(e.start - origin, along) / Cross(ray, along);
+  }
+
+  olc::vd2d Hit(const int edge, const olc::vd2d& ray) const
+  {
+    return origin + ray * Distance(edge, ray);
+  }
+
+  static void Emit(const olc::vd2d& point, std::vector<olc::vf2d>& polygon)
+  {
+    const olc::vf2d p = {(float)point.x, (float)point.y};
+
+    if (polygon.empty() || !Same(polygon.back(), p))
+    {
+      polygon.push_back(p);
+    }
+  }
+};
@@ -0,0 +1,223 @@
+#pragma once
+
+#include "olcPixelGameEngine.h"
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Remembers recently computed visibility polygons so that lights which do not move cost nothing
+ *
+ * Entries are keyed on the light position snapped to a configurable quantum, the scene
+ * generation (bumped whenever a wall changes) and a variant number for the method that
+ * produced the polygon. The least recently used entries are dropped once the polygons
+ * exceed the memory budget.
+ */
+class VisibilityCache
+{
+public:
+  /**
+   * @param budget Maximum number of bytes the cached polygons may occupy
+   * @param quantum Light positions are snapped to multiples of this many pixels
+   */
+  explicit VisibilityCache(const size_t budget = 32 * 1024 * 1024, const float quantum = 1.0f) : budget(budget), quantum(quantum)
+  {
+  }
+
+  void SetBudget(const size_t bytes)
+  {
+    budget = bytes;
+    Evict();
+  }
+
+  void SetQuantum(const float pixels)
+  {
+    quantum = pixels;
+    Clear();
+  }
+
+  void Clear()
+  {
+    entries.clear();
+    lookup.clear();
+    bytes = 0;
+  }
+
+  size_t Bytes() const
+  {
+    return bytes;
+  }
+
+  size_t Size() const
+  {
+    return entries.size();
+  }
+
+  /**
+   * @brief Snaps a light position to the quantum, polygons should be computed for this position
+   */
+  olc::vf2d Quantize(const olc::vf2d& light) const
+  {
+    return olc::vf2d(std::round(light.x / quantum), std::round(light.y / quantum)) * quantum;
+  }
+
+  /**
+   * @brief Looks up a polygon and marks it as recently used
+   *
+   * @param light Position of the light, snapped with Quantize()
+   * @param generation The current scene generation
+   * @param variant Identifies the method the polygon was computed with
+   * @param polygon Receives a copy of the cached polygon
+   * @return bool Whether the polygon was cached
+   */
+  bool Find(const olc::vf2d& light, const uint64_t generation, const int variant, std::vector<olc::vf2d>& polygon)
+  {
+    const auto found = lookup.find(MakeKey(light, generation, variant));
+    if (found == lookup.end())
+    {
+      return false;
+    }
+
+    entries.splice(entries.begin(), entries, found->second);
+    polygon = found->second->polygon;
+    return true;
+  }
+
+  /**
+   * @brief Stores a polygon, evicting the least recently used ones if the budget is exceeded
+   */
+  void Store(const olc::vf2d& light, const uint64_t generation, const int variant, const std::vector<olc::vf2d>& polygon)
+  {
+    const Key key = MakeKey(light, generation, variant);
+    const auto found = lookup.find(key);
+
+    if (found != lookup.end())
+    {
+      bytes -= Footprint(found->second->polygon);
+      found->second->polygon = polygon;
+      bytes += Footprint(found->second->polygon);
+      entries.splice(entries.begin(), entries, found->second);
+    }
+    else
+    {
+      entries.push_front({key, polygon});
+      lookup[key] = entries.begin();
+      bytes += Footprint(entries.front().polygon);
+    }
+
+    Evict();
+  }
+
+  /**
+   * @brief Carries the most recently used polygons over to a new scene generation
+   *
+   * @param from The generation the polygons were computed for
+   * @param to The generation they are moved to
+   * @param limit At most this many polygons are patched, older ones are left to go stale
+   * @param patch Gets the light position, variant and polygon, returns false if the polygon
+   * could not be patched, which drops it from the cache
+   */
+  void Patch(const uint64_t from, const uint64_t to, size_t limit, const std::function<bool(const olc::vf2d&, int, std::vector<olc::vf2d>&)>& patch)
+  {
+    auto entry = entries.begin();
+
+    while (entry != entries.end() && limit > 0)
+    {
+      if (entry->key.generation != from)
+      {
+        ++entry;
+        continue;
+      }
+
+      limit--;
+      lookup.erase(entry->key);
+      bytes -= Footprint(entry->polygon);
+
+      const olc::vf2d light = olc::vf2d((float)entry->key.x, (float)entry->key.y) * quantum;
+      if (!patch(light, entry->key.variant, entry->polygon))
+      {
+        entry = entries.erase(entry);
+        continue;
+      }
+
+      entry->key.generation = to;
+      bytes += Footprint(entry->polygon);
+
+      // Another entry may already hold this key, the patched one is more recent
+      const auto existing = lookup.find(entry->key);
+      if (existing != lookup.end())
+      {
+        bytes -= Footprint(existing->second->polygon);
+        entries.erase(existing->second);
+      }
+
+      lookup[entry->key] = entry;
+      ++entry;
+    }
+
+    Evict();
+  }
+
+private:
+  struct Key
+  {
+    int32_t x;
+    int32_t y;
+    uint64_t generation;
+    int variant;
+
+    bool operator==(const Key& other) const
+    {
+      return x == other.x && y == other.y && generation == other.generation && variant == other.variant;
+    }
+  };
+
+  struct KeyHash
+  {
+    size_t operator()(const Key& key) const
+    {
+      uint64_t hash = ((uint64_t)(uint32_t)key.x << 32) | (uint32_t)key.y;
+      hash ^= (key.generation + 0x9e3779b97f4a7c15ull) + (hash << 6) + (hash >> 2);
+      hash ^= ((uint64_t)key.variant + 0x9e3779b97f4a7c15ull) + (hash << 6) + (hash >> 2);
+      return (size_t)hash;
+    }
+  };
+
+  struct Entry
+  {
+    Key key;
+    std::vector<olc::vf2d> polygon;
+  };
+
+  size_t budget;
+  float quantum;
+  size_t bytes = 0;
+
+  // Most recently used entries are at the front
+  std::list<Entry> entries;
+  std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> lookup;
+
+  Key MakeKey(const olc::vf2d& light, const uint64_t generation, const int variant) const
+  {
+    return {(int32_t)std::lround(light.x / quantum), (int32_t)std::lround(light.y / quantum), generation, variant};
+  }
+
+  static size_t Footprint(const std::vector<olc::vf2d>& polygon)
+  {
+    // The list node and hash map entry cost roughly as much as a few dozen bytes
+    return sizeof(Entry) + 64 + polygon.capacity() * sizeof(olc::vf2d);
+  }
+
+  void Evict()
+  {
+    while (bytes > budget && !entries.empty())
+    {
+      bytes -= Footprint(entries.back().polygon);
+      lookup.erase(entries.back().key);
+      entries.pop_back();
+    }
+  }
+};
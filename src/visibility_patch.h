@@ -0,0 +1,278 @@
+#pragma once
+
+#include "olcPixelGameEngine.h"
+#include "occluder_index.h"
+#include "visibility.h"
+#include <cmath>
+#include <vector>
+
+/**
+ * @brief Updates an existing visibility polygon after a single wall was added or removed
+ *
+ * Only the wedge of directions covered by the changed wall can change. The polygon is
+ * recomputed inside that wedge from a handful of candidate walls and spliced into the
+ * untouched remainder of the old polygon:
+ *  - an added wall competes with the old polygon's own edges inside the wedge
+ *  - a removed wall uncovers whatever the occluder index holds behind it
+ */
+class VisibilityPatcher
+{
+public:
+  /**
+   * @brief Patches a polygon after a wall was added
+   *
+   * @param solver Computes the polygon inside the wedge
+   * @param light Position of the light the polygon belongs to
+   * @param wall The new wall
+   * @param boundsMin Top left corner of the area the light is clipped to
+   * @param boundsMax Bottom right corner of the area the light is clipped to
+   * @param polygon The polygon to patch
+   * @return bool False if the polygon could not be patched and has to be recomputed
+   */
+  bool InsertWall(VisibilitySolver& solver, const olc::vf2d& light, const Segment& wall, const olc::vf2d& boundsMin, const olc::vf2d& boundsMax, std::vector<olc::vf2d>& polygon)
+  {
+    if (polygon.size() < 3)
+    {
+      return false;
+    }
+
+    // A wall seen edge-on casts no shadow
+    if (!SetWedge(light, wall, boundsMin, boundsMax))
+    {
+      return true;
+    }
+
+    candidates.clear();
+    candidates.push_back(wall);
+    for (size_t i = 0; i < polygon.size(); i++)
+    {
+      const Segment edge = {polygon[i], polygon[(i + 1) % polygon.size()]};
+
+      if (SegmentOverlapsBox(edge, wedgeMin, wedgeMax))
+      {
+        candidates.push_back(edge);
+      }
+    }
+
+    return Splice(solver, light, boundsMin, boundsMax, polygon);
+  }
+
+  /**
+   * @brief Patches a polygon after a wall was removed
+   *
+   * @param solver Computes the polygon inside the wedge
+   * @param light Position of the light the polygon belongs to
+   * @param wall The removed wall
+   * @param index The remaining walls, the removed one must no longer be in it
+   * @param boundsMin Top left corner of the area the light is clipped to
+   * @param boundsMax Bottom right corner of the area the light is clipped to
+   * @param polygon The polygon to patch
+   * @return bool False if the polygon could not be patched and has to be recomputed
+   */
+  bool RemoveWall(VisibilitySolver& solver, const olc::vf2d& light, const Segment& wall, const OccluderIndex& index, const olc::vf2d& boundsMin, const olc::vf2d& boundsMax, std::vector<olc::vf2d>& polygon)
+  {
+    if (polygon.size() < 3)
+    {
+      return false;
+    }
+
+    if (!SetWedge(light, wall, boundsMin, boundsMax))
+    {
+      return true;
+    }
+
+    candidates.clear();
+    index.Query(wedgeMin, wedgeMax, candidates);
+
+    return Splice(solver, light, boundsMin, boundsMax, polygon);
+  }
+
+private:
+  static constexpr double twoPi = 2.0 * M_PI;
+  static constexpr double tolerance = 1e-6;
+  // Vertices where a ray meets a wall are rounded to float, which moves them this far
+  static constexpr double rounding = 1e-3;
+
+  double wedgeStart = 0.0;
+  double wedgeExtent = 0.0;
+  olc::vf2d wedgeMin;
+  olc::vf2d wedgeMax;
+
+  std::vector<Segment> candidates;
+  std::vector<olc::vf2d> fresh;
+  std::vector<olc::vf2d> patched;
+
+  /**
+   * @brief Angle of a point counter-clockwise from the start of the wedge, in (-pi, pi]
+   */
+  double Relative(const olc::vf2d& light, const olc::vf2d& point) const
+  {
+    double angle = std::atan2((double)point.y - light.y, (double)point.x - light.x) - wedgeStart;
+
+    while (angle > M_PI)
+    {
+      angle -= twoPi;
+    }
+    while (angle <= -M_PI)
+    {
+      angle += twoPi;
+    }
+
+    return angle;
+  }
+
+  /**
+   * @brief Angle of a point counter-clockwise from the end of the wedge, in [0, 2pi)
+   *
+   * Unlike Relative() this never wraps around between two vertices outside the wedge.
+   */
+  double PastWedge(const olc::vf2d& light, const olc::vf2d& point) const
+  {
+    const double angle = std::fmod(std::atan2((double)point.y - light.y, (double)point.x - light.x) - wedgeStart - wedgeExtent, twoPi);
+    return (angle < 0.0) ? angle + twoPi : angle;
+  }
+
+  /**
+   * @brief How far off the angle of a point may be, close to the light rounding turns into a larger angle
+   */
+  static double Slack(const olc::vf2d& light, const olc::vf2d& point)
+  {
+    return tolerance + rounding / std::hypot((double)point.x - light.x, (double)point.y - light.y);
+  }
+
+  bool Inside(const olc::vf2d& light, const olc::vf2d& point) const
+  {
+    const double slack = Slack(light, point);
+    const double angle = Relative(light, point);
+    return angle >= -slack && angle <= wedgeExtent + slack;
+  }
+
+  /**
+   * @brief Where a ray from the light leaves the bounds
+   */
+  static olc::vf2d Exit(const olc::vf2d& light, const olc::vf2d& ray, const olc::vf2d& boundsMin, const olc::vf2d& boundsMax)
+  {
+    const float reach = std::min(
+      (ray.x > 0.0f) ? (boundsMax.x - light.x) / ray.x : (ray.x < 0.0f) ? (boundsMin.x - light.x) / ray.x : INFINITY,
+      (ray.y > 0.0f) ? (boundsMax.y - light.y) / ray.y : (ray.y < 0.0f) ? (boundsMin.y - light.y) / ray.y : INFINITY);
+
+    return light + ray * reach;
+  }
+
+  /**
+   * @brief Computes the wedge of directions a wall covers and the box enclosing it within the bounds
+   *
+   * @return bool False if the wall is seen edge-on and covers no directions
+   */
+  bool SetWedge(const olc::vf2d& light, const Segment& wall, const olc::vf2d& boundsMin, const olc::vf2d& boundsMax)
+  {
+    olc::vf2d first = wall.start - light;
+    olc::vf2d second = wall.end - light;
+
+    double cross = (double)first.x * second.y - (double)first.y * second.x;
+    if (std::abs(cross) < 1e-9)
+    {
+      return false;
+    }
+
+    if (cross < 0.0)
+    {
+      std::swap(first, second);
+      cross = -cross;
+    }
+
+    wedgeStart = std::atan2((double)first.y, (double)first.x);
+    wedgeExtent = std::atan2(cross, (double)first.x * second.x + (double)first.y * second.y);
+
+    const olc::vf2d firstExit = Exit(light, first, boundsMin, boundsMax);
+    const olc::vf2d secondExit = Exit(light, second, boundsMin, boundsMax);
+
+    wedgeMin = light.min(firstExit).min(secondExit);
+    wedgeMax = light.max(firstExit).max(secondExit);
+
+    for (const olc::vf2d& corner : {boundsMin, olc::vf2d(boundsMax.x, boundsMin.y), boundsMax, olc::vf2d(boundsMin.x, boundsMax.y)})
+    {
+      if (Inside(light, corner))
+      {
+        wedgeMin = wedgeMin.min(corner);
+        wedgeMax = wedgeMax.max(corner);
+      }
+    }
+
+    return true;
+  }
+
+  /**
+   * @brief Replaces the part of the polygon inside the wedge with a polygon computed from the candidates
+   */
+  bool Splice(VisibilitySolver& solver, const olc::vf2d& light, const olc::vf2d& boundsMin, const olc::vf2d& boundsMax, std::vector<olc::vf2d>& polygon)
+  {
+    // Inside the wedge the candidates are all that matter, outside of it the result is discarded
+    solver.Compute(light, candidates, boundsMin, boundsMax, fresh);
+    if (fresh.size() < 3)
+    {
+      return false;
+    }
+
+    patched.clear();
+
+    // Both polygons are in angular order, so the part inside the wedge is a single run
+    // of vertices, starting right after one outside of it
+    const size_t freshCount = fresh.size();
+    for (size_t i = 0; i < freshCount; i++)
+    {
+      if (Inside(light, fresh[i]) && !Inside(light, fresh[(i + freshCount - 1) % freshCount]))
+      {
+        for (size_t j = 0; j < freshCount && Inside(light, fresh[(i + j) % freshCount]); j++)
+        {
+          patched.push_back(fresh[(i + j) % freshCount]);
+        }
+        break;
+      }
+    }
+
+    // The rest of the old polygon runs from the first vertex past the end of the wedge
+    // around to just before its start
+    const size_t oldCount = polygon.size();
+    size_t first = oldCount;
+    double firstAngle = twoPi;
+    for (size_t i = 0; i < oldCount; i++)
+    {
+      const double angle = PastWedge(light, polygon[i]);
+      if (angle < firstAngle && !Inside(light, polygon[i]))
+      {
+        first = i;
+        firstAngle = angle;
+      }
+    }
+
+    if (first == oldCount)
+    {
+      return false;
+    }
+
+    // Vertices in the same direction, like both ends of a shadow edge, keep their order
+    for (size_t j = 1; j < oldCount; j++)
+    {
+      const size_t previous = (first + oldCount - 1) % oldCount;
+      if (Inside(light, polygon[previous]) || PastWedge(light, polygon[previous]) > firstAngle + Slack(light, polygon[previous]))
+      {
+        break;
+      }
+      first = previous;
+    }
+
+    for (size_t j = 0; j < oldCount && !Inside(light, polygon[(first + j) % oldCount]); j++)
+    {
+      patched.push_back(polygon[(first + j) % oldCount]);
+    }
+
+    if (patched.size() < 3)
+    {
+      return false;
+    }
+
+    polygon.swap(patched);
+    return true;
+  }
+};